@@ -10,93 +10,79 @@ public:
 		drawFunc(_drawFunc) {}
 };
 
+#define BUFFER_INDEX_MASK	0x3
+#define BUFFER_FRESH		0x4
+
 class DrawBuffer {
-private:
-	CRITICAL_SECTION cSec;
 public:
 	std::vector<DrawItem> drawItems;
 	std::vector<DrawItem> drawItemsTop;
 
-	DrawBuffer(){
-		InitializeCriticalSection(&cSec);
-	}
-
-	~DrawBuffer(){
-		DeleteCriticalSection(&cSec);
-	}
-
 	void draw(){
-		lock();
 		for (auto it = drawItems.begin(); it != drawItems.end(); it++){
 			it->drawFunc();
 		}
 		for (auto it = drawItemsTop.begin(); it != drawItemsTop.end(); it++){
 			it->drawFunc();
 		}
-		unlock();
 	}
 
 	void clear(){
-		//lock();
 		drawItems.clear();
 		drawItemsTop.clear();
-		//unlock();
-	}
-
-	void lock(){
-		EnterCriticalSection(&cSec);
-	}
-
-	void unlock(){
-		LeaveCriticalSection(&cSec);
 	}
 };
 
-AsyncDrawBuffer::AsyncDrawBuffer()
+AsyncDrawBuffer::AsyncDrawBuffer() :
+	front(0),
+	back(1),
+	middle(2)
 {
-	fg = new DrawBuffer();
-	bg = new DrawBuffer();
+	for (int i = 0; i < 3; i++){
+		buffers[i] = new DrawBuffer();
+	}
 }
 
 
 AsyncDrawBuffer::~AsyncDrawBuffer()
 {
-	delete bg;
-	delete fg;
+	for (int i = 0; i < 3; i++){
+		delete buffers[i];
+	}
 }
 
 
 // Calls all buffered draws
 void AsyncDrawBuffer::drawAll()
 {
-	fg->draw();
+	// Take the newest frame if one was published since the last draw
+	if (middle.load(std::memory_order_relaxed) & BUFFER_FRESH){
+		front = middle.exchange(front, std::memory_order_acq_rel) & BUFFER_INDEX_MASK;
+	}
+	buffers[front]->draw();
 }
 
 
 // Pushes a draw function into the buffer
 void AsyncDrawBuffer::push(std::function<void()> drawCall)
 {
-	bg->drawItems.push_back(DrawItem(drawCall));
+	buffers[back]->drawItems.push_back(DrawItem(drawCall));
 }
 
 // Pushes a draw function into the buffer that gets drawn last
 void AsyncDrawBuffer::push_top_layer(std::function<void()> drawCall)
 {
-	bg->drawItemsTop.push_back(DrawItem(drawCall));
+	buffers[back]->drawItemsTop.push_back(DrawItem(drawCall));
 }
 
 void AsyncDrawBuffer::clear()
 {
-	bg->clear();
+	buffers[back]->clear();
 }
 
 void AsyncDrawBuffer::swapBuffers()
 {
-	auto f = fg;
-	f->lock();
-	fg = bg;
-	bg = f;
-	f->unlock();
+	back = middle.exchange(back | BUFFER_FRESH, std::memory_order_acq_rel) & BUFFER_INDEX_MASK;
 }
 
 DrawDirective::DrawDirective(bool _synchronous, unsigned char _maxGhost) :
@@ -130,7 +116,9 @@ void DrawDirective::drawInternal(fpDirector director)
 
 void DrawDirective::draw(fpDirector director)
 {
-	if (forcedUpdate || !updatePending && frameCount > maxGhost){
+	// Only one build may fill the back buffer at a time, a forced update
+	// waits for the pending one to be published.
+	if (!updatePending && (forcedUpdate || frameCount > maxGhost)){
 		updatePending = true;
 		forcedUpdate = false;
 		if (synchronous){
@@ -139,7 +127,7 @@ void DrawDirective::draw(fpDirector director)
 		else{
 			Task::Enqueue([=]()->void{
 				drawInternal(director);
-			});
+			}, Task::FrameCritical);
 		}
 	}
 
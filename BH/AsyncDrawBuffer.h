@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include "Task.h"
 
 class DrawBuffer;
@@ -7,16 +8,21 @@ class AsyncDrawBuffer;
 
 typedef std::function<void(AsyncDrawBuffer&)> fpDirector;
 
+// Triple buffered: the producer fills the back buffer and publishes it by
+// exchanging it with the middle buffer, the renderer picks up the middle
+// buffer the same way. Neither side ever waits on the other.
 class AsyncDrawBuffer
 {
 private:
-	DrawBuffer* fg;
-	DrawBuffer* bg;
+	DrawBuffer* buffers[3];
+	int front;					// Only touched by the renderer
+	int back;					// Only touched by the producer
+	std::atomic<int> middle;	// Index of the latest complete buffer, plus a fresh flag
 public:
 	AsyncDrawBuffer();
 	~AsyncDrawBuffer();
 
-	// Calls all buffered draw calls in the fore buffer
+	// Calls all buffered draw calls in the latest complete buffer
 	void drawAll();
 
 	// Pushes a draw function into the back buffer
@@ -26,14 +32,14 @@ public:
 	// Clears the backbuffer
 	void clear();
 
-	// Switches the fore and back buffers to change the displayed frame
+	// Publishes the back buffer as the latest complete frame
 	void swapBuffers();
 };
 
 class DrawDirective {
 private:
 	int frameCount;
-	bool updatePending;
+	std::atomic<bool> updatePending;
 	AsyncDrawBuffer buffer;
 	bool forcedUpdate;
 	bool synchronous;
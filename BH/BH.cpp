@@ -10,6 +10,7 @@
 #include "MPQInit.h"
 #include "TableReader.h"
 #include "Task.h"
+#include "TaskGraph.h"
 
 string BH::path;
 HINSTANCE BH::instance;
@@ -70,7 +71,7 @@ bool BH::Startup(HINSTANCE instance, VOID* reserved) {
 	return true;
 }
 
-DWORD WINAPI LoadMPQData(VOID* lpvoid){
+std::string GetPatchPath(){
 	char szFileName[1024];
 	std::string patchPath;
 	UINT ret = GetModuleFileName(NULL, szFileName, 1024);
@@ -82,12 +83,51 @@ DWORD WINAPI LoadMPQData(VOID* lpvoid){
 			patchPath.replace(start_pos, patchPath.size() - start_pos, "Patch_D2.mpq");
 		}
 	}
+	return patchPath;
+}
+
+// Reading the archive comes first, after that the stat, inventory and item
+// data and every table are parsed in parallel. Modules are told as soon as
+// the data they depend on is ready.
+void LoadMPQDataAsync(){
+	std::shared_ptr<Task::Graph> graph = Task::Graph::Create();
+
+	Task::Graph::Node files = graph->Add([]() -> void {
+		ReadMPQFiles(GetPatchPath());
+		BH::moduleManager->MpqDataReady(MPQ_FILES);
+	});
 
-	ReadMPQFiles(patchPath);
-	InitializeMPQData();
-	Tables::initTables();
+	Task::Graph::Node stats = graph->Add([]() -> void {
+		InitializeStatData();
+		BH::moduleManager->MpqDataReady(MPQ_STATS);
+	}, { files });
+	Task::Graph::Node inventory = graph->Add([]() -> void {
+		InitializeInventoryData();
+		BH::moduleManager->MpqDataReady(MPQ_INVENTORY);
+	}, { files });
+	Task::Graph::Node items = graph->Add([]() -> void {
+		InitializeItemData();
+		BH::moduleManager->MpqDataReady(MPQ_ITEMS);
+	}, { files });
+	// Its own flag, so modules that wait for everything see IsInitialized()
+	graph->Add([]() -> void {
+		FinishMPQData();
+		BH::moduleManager->MpqDataReady(MPQ_FINISHED);
+	}, { stats, inventory, items });
+
+	if (Tables::beginInit()) {
+		std::vector<Task::Graph::Node> tables;
+		for (int i = 0; i < Tables::tableCount(); i++) {
+			tables.push_back(graph->Add([i]() -> void {
+				Tables::loadTable(i);
+			}, { files }));
+		}
+		graph->Add([]() -> void {
+			BH::moduleManager->MpqDataReady(MPQ_TABLES);
+		}, tables);
+	}
 
-	return 0;
+	graph->Start();
 }
 
 void BH::Initialize()
@@ -119,14 +159,10 @@ void BH::Initialize()
 
 	settingsUI = new Drawing::UI(BH_VERSION, 400, 277);
 
-	Task::InitializeThreadPool(2);
+	Task::InitializeThreadPool();
 
 	// Read the MPQ Data asynchronously
-	//CreateThread(0, 0, LoadMPQData, 0, 0, 0);
-	Task::Enqueue([]() -> void {
-		LoadMPQData(NULL);
-		moduleManager->MpqLoaded();
-	});
+	LoadMPQDataAsync();
 
 	
 	new ScreenInfo();
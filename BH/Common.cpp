@@ -222,6 +222,19 @@ ULONGLONG BHGetTickCount(void) {
     return (ULONGLONG)GetTickCount();
 }
 
+// High resolution timer for measuring work in the sub-millisecond range,
+// GetTickCount only has a resolution of ~15ms.
+ULONGLONG BHGetMicroseconds(void) {
+	static LARGE_INTEGER frequency = { 0 };
+	LARGE_INTEGER counter;
+
+	if (!frequency.QuadPart)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (ULONGLONG)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+		(ULONGLONG)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
+
 // See: http://stackoverflow.com/questions/2342162/stdstring-formatting-like-sprintf
 std::string string_format(const std::string fmt_str, ...) {
 	int final_n, n = ((int)fmt_str.size()) * 2; /* Reserve two times as much as the length of the fmt_str */
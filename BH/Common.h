@@ -82,6 +82,7 @@ struct KeyCode {
 KeyCode GetKeyCode(unsigned int nKey);
 KeyCode GetKeyCode(const char* name);
 ULONGLONG BHGetTickCount(void);
+ULONGLONG BHGetMicroseconds(void);
 
 std::string string_format(const std::string fmt_str, ...);
 
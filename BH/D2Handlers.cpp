@@ -5,10 +5,12 @@
 #include <iterator>
 
 void GameDraw() {
+	Drawing::TextCache::NextFrame();
 	__raise BH::moduleManager->OnDraw();
 	Drawing::UI::Draw();
 	Drawing::StatsDisplay::Draw();
 	Drawing::Hook::Draw(Drawing::InGame);
+	BH::moduleManager->DrawProfiler();
 }
 
 void GameAutomapDraw() {
@@ -16,6 +18,7 @@ void GameAutomapDraw() {
 }
 
 void OOGDraw() {
+	Drawing::TextCache::NextFrame();
 	Drawing::Hook::Draw(Drawing::OutOfGame);
 	__raise BH::moduleManager->OnOOGDraw();
 }
@@ -2,6 +2,8 @@
 
 #include "Drawing\Basic\Boxhook\Boxhook.h"
 #include "Drawing\Basic\Texthook\Texthook.h"
+#include "Drawing\Basic\Texthook\TextBatch.h"
+#include "Drawing\Basic\Texthook\TextCache.h"
 #include "Drawing\Basic\Crosshook\Crosshook.h"
 #include "Drawing\Basic\Framehook\Framehook.h"
 #include "Drawing\Basic\Linehook\Linehook.h"
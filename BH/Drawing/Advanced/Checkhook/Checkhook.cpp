@@ -2,6 +2,7 @@
 #include "../../../Common.h"
 #include "../../../D2Ptrs.h"
 #include "../../Basic/Framehook/Framehook.h"
+#include "../../Basic/Texthook/FontMetrics.h"
 
 using namespace Drawing;
 /* Basic Hook Initializer
@@ -19,6 +20,7 @@ Hook(visibility, x, y) {
 	vsprintf_s(buffer, 4096, formatString.c_str(), arg);
 	va_end(arg);
 	text = buffer;
+	BoundsChanged();
 }
 
 /* Group Hook Initializer
@@ -93,13 +95,7 @@ void Checkhook::SetText(std::string formatString, ...) {
  *	Returns how long the text is.
  */
 unsigned int Checkhook::GetXSize() {
-	DWORD width, fileNo;
-	wchar_t* wString = AnsiToUnicode(text.c_str());
-	DWORD oldFont = D2WIN_SetTextSize(0);
-	D2WIN_GetTextWidthFileNo(wString, &width, &fileNo);
-	D2WIN_SetTextSize(oldFont);
-	delete[] wString;
-	return width + 20; 
+	return FontMetrics::GetWidth(text.c_str(), 0) + 20;
 }
 
 /* GetXSize()
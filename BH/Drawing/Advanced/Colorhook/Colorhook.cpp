@@ -4,6 +4,7 @@
 #include "../../Basic/Boxhook/Boxhook.h"
 #include "../../Basic/Framehook/Framehook.h"
 #include "../../Basic/Texthook/Texthook.h"
+#include "../../Basic/Texthook/FontMetrics.h"
 #include "../../Basic/Crosshook/Crosshook.h"
 
 using namespace Drawing;
@@ -84,13 +85,7 @@ bool Colorhook::OnRightClick(bool up, unsigned int x, unsigned int y) {
  *	Returns how long the text is.
  */
 unsigned int Colorhook::GetXSize() {
-	DWORD width, fileNo;
-	wchar_t* wString = AnsiToUnicode(GetText().c_str());
-	DWORD oldFont = D2WIN_SetTextSize(0);
-	D2WIN_GetTextWidthFileNo(wString, &width, &fileNo);
-	D2WIN_SetTextSize(oldFont);
-	delete[] wString;
-	return width; 
+	return FontMetrics::GetWidth(GetText().c_str(), 0);
 }
 
 /* GetYSize()
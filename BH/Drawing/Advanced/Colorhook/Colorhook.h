@@ -25,6 +25,8 @@ namespace Drawing {
 
 			bool OnLeftClick(bool up, unsigned int x, unsigned int y);
 			bool OnRightClick(bool up, unsigned int x, unsigned int y);
+			// The open color picker is drawn in the middle of the screen
+			bool HitTestAlways() { return true; };
 			void OnDraw();
 
 			unsigned int GetXSize();
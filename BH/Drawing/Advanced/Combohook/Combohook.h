@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include "../../Hook.h"
+#include "../../Basic/Texthook/FontMetrics.h"
 
 namespace Drawing {
 	class Combohook : public Hook {
@@ -25,9 +26,11 @@ namespace Drawing {
 			unsigned int GetXSize() { return xSize; };
 			void SetXSize(unsigned int size) { Lock(); xSize = size; Unlock(); };
 
-			unsigned int GetYSize() { unsigned int height[] = {10,11,18,24,10,13,7,13,10,12,8,8,7,12}; return height[GetFont()]; };
+			unsigned int GetYSize() { return FontMetrics::GetHeight(GetFont()); };
 
 			bool OnLeftClick(bool up, unsigned int x, unsigned int y);
+			// The open dropdown extends below the hook's bounds
+			bool HitTestAlways() { return true; };
 			void OnDraw();
 
 			bool InHook(unsigned int nx, unsigned int ny) { return nx >= GetX() && ny >= GetY() && nx <= GetX() + GetXSize() + 5 && ny <= GetY() + GetYSize() + 3; };
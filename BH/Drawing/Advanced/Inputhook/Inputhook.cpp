@@ -122,14 +122,14 @@ unsigned int Inputhook::GetCharacterLimit() {
  void Inputhook::OnDraw() {
 	 Lock();
 	 //Font height
-	 unsigned int height[] = {10,11,18,24,10,13,7,13,10,12,8,8,7,12};
+	 unsigned int height = FontMetrics::GetHeight(GetFont());
 	 
 	 //Current text width
 	 POINT textSize = Texthook::GetTextSize(GetText().substr(textPos, GetCursorPosition() - textPos), GetFont());
 
 	 //Draw the outline box!
-	 RECT pRect  = {GetX(), GetY(), GetX() + GetXSize(), GetY() + height[GetFont()] + 4};
-	 D2GFX_DrawRectangle(GetX(), GetY(), GetX() + GetXSize(), GetY() + height[GetFont()] + 4, 0, BTFull);
+	 RECT pRect  = {GetX(), GetY(), GetX() + GetXSize(), GetY() + height + 4};
+	 D2GFX_DrawRectangle(GetX(), GetY(), GetX() + GetXSize(), GetY() + height + 4, 0, BTFull);
 	 Framehook::DrawRectStub(&pRect);
 	 string drawnText = text;
 
@@ -148,7 +148,7 @@ unsigned int Inputhook::GetCharacterLimit() {
 	
 	 DWORD oldFont = D2WIN_SetTextSize(GetFont());
 	 wchar_t* wText = AnsiToUnicode(drawnText.c_str());
-	 D2WIN_DrawText(wText, GetX() + 3, GetY() + 3 + height[GetFont()], 0, 0);
+	 D2WIN_DrawText(wText, GetX() + 3, GetY() + 3 + height, 0, 0);
 	 delete[] wText;
 	 D2WIN_SetTextSize(oldFont);
 
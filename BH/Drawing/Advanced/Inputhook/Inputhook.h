@@ -3,6 +3,7 @@
 #include <string>
 #include "../../Hook.h"
 #include "../../Basic/Texthook/Texthook.h"
+#include "../../Basic/Texthook/FontMetrics.h"
 
 namespace Drawing {
 	class Inputhook : public Hook {
@@ -37,7 +38,7 @@ namespace Drawing {
 			void SetXSize(unsigned int newXSize);
 
 			//Y Size
-			unsigned int GetYSize() { unsigned int height[] = {10,11,18,24,10,13,7,13,10,12,8,8,7,12}; return height[GetFont()]; };
+			unsigned int GetYSize() { return FontMetrics::GetHeight(GetFont()); };
 
 			//If we are current showing the cursor, for blinking purposes!
 			bool ShowCursor() { return showCursor; };
@@ -64,6 +65,8 @@ namespace Drawing {
 			bool OnKey(bool up, BYTE key, LPARAM lParam);
 			bool OnLeftClick(bool up, unsigned int x, unsigned int y);
 			bool OnRightClick(bool up, unsigned int x, unsigned int y);
+			// Clicking anywhere else drops focus
+			bool HitTestAlways() { return true; };
 
 			unsigned int GetCharacterLimit();
 
@@ -1,6 +1,7 @@
 #include "Keyhook.h"
 #include "../../../D2Ptrs.h"
 #include "../../../Common.h"
+#include "../../Basic/Texthook/FontMetrics.h"
 
 using namespace std;
 using namespace Drawing;
@@ -75,6 +76,7 @@ bool Keyhook::OnKey(bool up, BYTE kkey, LPARAM lParam) {
 				kkey = 0;
 			*key = (unsigned int)kkey;
 			timeout = 0;
+			BoundsChanged();
 		}
 		Unlock();
 		return true;
@@ -88,13 +90,7 @@ unsigned int Keyhook::GetXSize() {
 	if (name.length() > 0)
 		prefix = name + ":c4 ";
 	string text = prefix + keyCode.literalName;
-	DWORD width, fileNo;
-	wchar_t* wString = AnsiToUnicode(text.c_str());
-	DWORD oldFont = D2WIN_SetTextSize(0);
-	D2WIN_GetTextWidthFileNo(wString, &width, &fileNo);
-	D2WIN_SetTextSize(oldFont);
-	delete[] wString;
-	return width; 
+	return FontMetrics::GetWidth(text.c_str(), 0);
 }
 
 unsigned int Keyhook::GetYSize() {
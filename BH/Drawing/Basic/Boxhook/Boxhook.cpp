@@ -60,6 +60,7 @@ void Boxhook::SetXSize(unsigned int newX) {
 	Lock();
 	xSize = newX;
 	Unlock();
+	BoundsChanged();
 }
 
 /* GetYSize()
@@ -76,6 +77,7 @@ void Boxhook::SetYSize(unsigned int newY) {
 	Lock();
 	ySize = newY;
 	Unlock();
+	BoundsChanged();
 }
 
 /* GetTransparency()
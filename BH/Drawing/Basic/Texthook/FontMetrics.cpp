@@ -0,0 +1,117 @@
+#include "FontMetrics.h"
+#include "../../../Constants.h"
+#include "../../../D2Ptrs.h"
+#include <atomic>
+#include <unordered_map>
+
+using namespace Drawing;
+
+static const unsigned int fontHeights[FONT_COUNT] = {10,11,18,24,10,13,7,13,10,12,8,8,7,12};
+
+struct GlyphWidths {
+	WORD ansi[256];									// Indexed by CODE_PAGE byte
+	WORD wide[256];									// Indexed by character below 256
+	std::unordered_map<wchar_t, WORD> extended;		// Everything else, measured on demand
+};
+
+class FontMetricsLock {
+public:
+	CRITICAL_SECTION cSec;
+	FontMetricsLock() { InitializeCriticalSection(&cSec); }
+	~FontMetricsLock() { DeleteCriticalSection(&cSec); }
+};
+
+static FontMetricsLock metricsLock;
+static GlyphWidths glyphs[FONT_COUNT];
+static std::atomic<bool> captured[FONT_COUNT];
+
+// Must be called with the font already selected through D2WIN_SetTextSize
+static WORD MeasureGlyph(wchar_t c) {
+	wchar_t glyph[2] = { c, 0 };
+	DWORD width = 0, fileNo;
+	D2WIN_GetTextWidthFileNo(glyph, &width, &fileNo);
+	return (WORD)width;
+}
+
+static GlyphWidths& GetGlyphs(unsigned int font) {
+	font %= FONT_COUNT;
+	if (captured[font])
+		return glyphs[font];
+
+	EnterCriticalSection(&metricsLock.cSec);
+	if (!captured[font]) {
+		GlyphWidths& widths = glyphs[font];
+		DWORD oldFont = D2WIN_SetTextSize(font);
+		widths.ansi[0] = widths.wide[0] = 0;
+		for (int c = 1; c < 256; c++) {
+			char ansi = (char)c;
+			wchar_t converted = 0;
+			MultiByteToWideChar(CODE_PAGE, 0, &ansi, 1, &converted, 1);
+			widths.ansi[c] = MeasureGlyph(converted);
+			widths.wide[c] = MeasureGlyph((wchar_t)c);
+		}
+		D2WIN_SetTextSize(oldFont);
+		captured[font] = true;
+	}
+	LeaveCriticalSection(&metricsLock.cSec);
+	return glyphs[font];
+}
+
+static WORD GetExtendedWidth(GlyphWidths& widths, unsigned int font, wchar_t c) {
+	EnterCriticalSection(&metricsLock.cSec);
+	auto it = widths.extended.find(c);
+	if (it == widths.extended.end()) {
+		DWORD oldFont = D2WIN_SetTextSize(font);
+		it = widths.extended.insert(std::make_pair(c, MeasureGlyph(c))).first;
+		D2WIN_SetTextSize(oldFont);
+	}
+	WORD width = it->second;
+	LeaveCriticalSection(&metricsLock.cSec);
+	return width;
+}
+
+namespace Drawing {
+	namespace FontMetrics {
+		unsigned int GetHeight(unsigned int font) {
+			return fontHeights[font % FONT_COUNT];
+		}
+
+		unsigned int GetWidth(const char* text, unsigned int font) {
+			const GlyphWidths& widths = GetGlyphs(font);
+			unsigned int width = 0, line = 0;
+			for (const BYTE* c = (const BYTE*)text; *c; c++) {
+				if (*c == 0xFF && c[1] == 'c') {
+					if (!c[2])
+						break;
+					c += 2;
+				} else if (*c == '\n') {
+					width = max(width, line);
+					line = 0;
+				} else {
+					line += widths.ansi[*c];
+				}
+			}
+			return max(width, line);
+		}
+
+		unsigned int GetWidth(const wchar_t* text, unsigned int font) {
+			GlyphWidths& widths = GetGlyphs(font);
+			unsigned int width = 0, line = 0;
+			for (const wchar_t* c = text; *c; c++) {
+				if (*c == 0xFF && c[1] == L'c') {
+					if (!c[2])
+						break;
+					c += 2;
+				} else if (*c == L'\n') {
+					width = max(width, line);
+					line = 0;
+				} else if (*c < 256) {
+					line += widths.wide[*c];
+				} else {
+					line += GetExtendedWidth(widths, font % FONT_COUNT, *c);
+				}
+			}
+			return max(width, line);
+		}
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <Windows.h>
+
+#define FONT_COUNT 14
+
+namespace Drawing {
+	/*
+	 * FontMetrics measures text without calling into D2WIN. The first time a
+	 * font is measured the advance width of every character is captured from
+	 * D2WIN_GetTextWidthFileNo, after which a string's width is the sum of
+	 * its characters' widths, skipping color codes (c plus one character).
+	 * Multi-line text is as wide as its widest line.
+	 */
+	namespace FontMetrics {
+		unsigned int GetHeight(unsigned int font);
+
+		// Width of text in the code page the rest of BH uses (CODE_PAGE)
+		unsigned int GetWidth(const char* text, unsigned int font);
+		unsigned int GetWidth(const wchar_t* text, unsigned int font);
+	}
+}
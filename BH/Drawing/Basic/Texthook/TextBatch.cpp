@@ -0,0 +1,74 @@
+#include "TextBatch.h"
+#include "FontMetrics.h"
+#include "../../../D2Ptrs.h"
+#include <vector>
+
+using namespace Drawing;
+
+struct QueuedText {
+	unsigned int x, y;
+	unsigned int font;
+	unsigned int color;
+	size_t offset;	// Start of the text in the character pool
+};
+
+static std::vector<QueuedText> queued;
+static std::vector<wchar_t> pool;
+static std::vector<unsigned int> order;
+static int depth = 0;
+
+namespace Drawing {
+	namespace TextBatch {
+		void Begin() {
+			depth++;
+		}
+
+		void End() {
+			if (depth == 0 || --depth > 0 || queued.empty())
+				return;
+
+			// Counting sort by font keeps the call order within each font
+			unsigned int counts[FONT_COUNT + 1] = { 0 };
+			for (auto it = queued.begin(); it != queued.end(); it++)
+				counts[min(it->font, (unsigned int)FONT_COUNT)]++;
+			unsigned int start = 0;
+			for (int n = 0; n <= FONT_COUNT; n++) {
+				unsigned int count = counts[n];
+				counts[n] = start;
+				start += count;
+			}
+			order.resize(queued.size());
+			for (unsigned int n = 0; n < queued.size(); n++)
+				order[counts[min(queued[n].font, (unsigned int)FONT_COUNT)]++] = n;
+
+			DWORD oldFont = D2WIN_SetTextSize(queued[order[0]].font);
+			unsigned int font = queued[order[0]].font;
+			for (auto it = order.begin(); it != order.end(); it++) {
+				QueuedText& text = queued[*it];
+				if (text.font != font) {
+					font = text.font;
+					D2WIN_SetTextSize(font);
+				}
+				D2WIN_DrawText(&pool[text.offset], text.x, text.y, text.color, 0);
+			}
+			D2WIN_SetTextSize(oldFont);
+
+			// Keep the capacity, the same overlays are drawn again next frame
+			queued.clear();
+			pool.clear();
+		}
+
+		void Draw(const wchar_t* text, unsigned int x, unsigned int y, unsigned int font, unsigned int color) {
+			if (depth == 0) {
+				DWORD oldFont = D2WIN_SetTextSize(font);
+				D2WIN_DrawText(text, x, y, color, 0);
+				D2WIN_SetTextSize(oldFont);
+				return;
+			}
+
+			QueuedText entry = { x, y, font, color, pool.size() };
+			queued.push_back(entry);
+			pool.insert(pool.end(), text, text + wcslen(text) + 1);
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <Windows.h>
+
+namespace Drawing {
+	/*
+	 * TextBatch defers text drawn between Begin() and End() and draws it all
+	 * at End(), grouped by font, so each font is selected once instead of
+	 * once per string. Text keeps its call order within a font, but ends up
+	 * above any boxes or lines drawn inside the batch, so only open a batch
+	 * around draws where that doesn't matter (labels, overlays).
+	 *
+	 * Batches nest, the text is drawn when the outermost one ends. Only used
+	 * from the draw thread.
+	 */
+	namespace TextBatch {
+		void Begin();
+		void End();
+
+		// Draws the text at the already aligned position, or queues it if a batch is open
+		void Draw(const wchar_t* text, unsigned int x, unsigned int y, unsigned int font, unsigned int color);
+	}
+}
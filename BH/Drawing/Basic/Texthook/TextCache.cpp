@@ -0,0 +1,81 @@
+#include "TextCache.h"
+#include "FontMetrics.h"
+#include "../../../Common.h"
+#include <unordered_map>
+
+// Entries unused for this many frames are dropped, sooner if the cache grows too large
+#define TEXT_CACHE_MAX_AGE		250
+#define TEXT_CACHE_MAX_ENTRIES	4096
+#define TEXT_CACHE_SWEEP		64
+
+using namespace Drawing;
+
+class TextCacheLock {
+public:
+	CRITICAL_SECTION cSec;
+	TextCacheLock() { InitializeCriticalSection(&cSec); }
+	~TextCacheLock() { DeleteCriticalSection(&cSec); }
+};
+
+static TextCacheLock cacheLock;
+static std::unordered_map<std::string, TextLayout> layouts[FONT_COUNT];
+static unsigned int frame = 0;
+static unsigned int entries = 0;
+
+template <typename Map>
+static unsigned int Evict(Map& map, unsigned int maxAge) {
+	unsigned int removed = 0;
+	for (auto it = map.begin(); it != map.end();) {
+		if (frame - it->second.lastFrame > maxAge) {
+			it = map.erase(it);
+			removed++;
+		} else {
+			it++;
+		}
+	}
+	return removed;
+}
+
+namespace Drawing {
+	namespace TextCache {
+		const TextLayout* Get(const char* text, unsigned int font, bool measure) {
+			font %= FONT_COUNT;
+			EnterCriticalSection(&cacheLock.cSec);
+			auto it = layouts[font].find(text);
+			if (it == layouts[font].end()) {
+				wchar_t* wString = AnsiToUnicode(text);
+				TextLayout layout;
+				layout.text = wString;
+				layout.width = 0;
+				layout.measured = false;
+				delete[] wString;
+				it = layouts[font].insert(std::make_pair(std::string(text), layout)).first;
+				entries++;
+			}
+
+			TextLayout* layout = &it->second;
+			layout->lastFrame = frame;
+			if (measure && !layout->measured) {
+				layout->width = FontMetrics::GetWidth(layout->text.c_str(), font);
+				layout->measured = true;
+			}
+			LeaveCriticalSection(&cacheLock.cSec);
+			return layout;
+		}
+
+		void NextFrame() {
+			frame++;
+			bool full = entries > TEXT_CACHE_MAX_ENTRIES;
+			if (frame % TEXT_CACHE_SWEEP != 0 && !full)
+				return;
+
+			// When full, keep only what was drawn in the last frame
+			unsigned int maxAge = full ? 1 : TEXT_CACHE_MAX_AGE;
+			EnterCriticalSection(&cacheLock.cSec);
+			for (int font = 0; font < FONT_COUNT; font++) {
+				entries -= Evict(layouts[font], maxAge);
+			}
+			LeaveCriticalSection(&cacheLock.cSec);
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <Windows.h>
+#include <string>
+
+namespace Drawing {
+	// A piece of text converted for D2WIN, with its width once it's been measured
+	struct TextLayout {
+		std::wstring text;
+		unsigned int width;
+		bool measured;
+		unsigned int lastFrame;
+	};
+
+	/*
+	 * TextCache remembers the converted wide string and measured width of
+	 * everything drawn through Texthook, keyed by (text, font). Labels that
+	 * are drawn every frame (monster names, level names, stat lines) skip
+	 * the conversion and measuring after the first frame. Entries
+	 * nobody drew for a while are evicted from NextFrame().
+	 */
+	namespace TextCache {
+		// Returns the layout of the text, measuring it first if asked to. The
+		// pointer stays valid until the next NextFrame() on the draw thread.
+		const TextLayout* Get(const char* text, unsigned int font, bool measure);
+
+		// Called once per drawn frame, evicts entries that haven't been used recently
+		void NextFrame();
+	}
+}
@@ -1,4 +1,7 @@
 #include "Texthook.h"
+#include "TextCache.h"
+#include "TextBatch.h"
+#include "FontMetrics.h"
 #include "../../../Common.h"
 #include "../../../D2Ptrs.h"
 
@@ -53,6 +56,7 @@ void Texthook::SetFont(unsigned int newFont) {
 	Lock();
 	font = newFont;
 	Unlock();
+	BoundsChanged();
 }
 
 /* GetColor()
@@ -104,27 +108,21 @@ void Texthook::SetText(std::string formatString, ...) {
 	vsprintf_s(buffer, 4096, formatString.c_str(), arg);
 	va_end(arg);
 	text = buffer;
+	BoundsChanged();
 }
 
 /* GetXSize()
  *	Returns how long the text is.
  */
 unsigned int Texthook::GetXSize() {
-	DWORD width, fileNo;
-	wchar_t* wString = AnsiToUnicode(text.c_str());
-	DWORD oldFont = D2WIN_SetTextSize(font);
-	D2WIN_GetTextWidthFileNo(wString, &width, &fileNo);
-	D2WIN_SetTextSize(oldFont);
-	delete[] wString;
-	return width; 
+	return FontMetrics::GetWidth(text.c_str(), font);
 }
 
 /* GetXSize()
  *	Returns how tall the text is.
  */
 unsigned int Texthook::GetYSize() {
-	unsigned int nHeight[] = {10,11,18,24,10,13,7,13,10,12,8,8,7,12};
-	return nHeight[font];
+	return FontMetrics::GetHeight(font);
 }
 
 /* Draw()
@@ -135,16 +133,15 @@ void Texthook::OnDraw() {
 		return;
 
 	Lock();
-	wchar_t* wString = AnsiToUnicode(text.c_str());
+	const TextLayout* layout = TextCache::Get(text.c_str(), font, false);
 
 	unsigned int drawColor = color;
 	if (InRange(*p_D2CLIENT_MouseX, *p_D2CLIENT_MouseY) && GetHoverColor() != Disabled)
 		drawColor = hoverColor;
 
 	DWORD oldFont = D2WIN_SetTextSize(font);
-	D2WIN_DrawText(wString, GetX(), GetY() + GetYSize(), drawColor, 0);
+	D2WIN_DrawText((wchar_t*)layout->text.c_str(), GetX(), GetY() + GetYSize(), drawColor, 0);
 	D2WIN_SetTextSize(oldFont);
-	delete[] wString;
 	Unlock();
 }
 
@@ -180,24 +177,12 @@ bool Texthook::OnRightClick(bool up, unsigned int x, unsigned int y) {
  *	Returns the dimensions of the given text!
  */
 POINT Texthook::GetTextSize(string text, unsigned int font) {
-	unsigned int height[] = {10,11,18,24,10,13,7,13,10,12,8,8,7,12};
-	DWORD width, fileNo;
-	wchar_t* wString = AnsiToUnicode(text.c_str());
-	DWORD oldFont = D2WIN_SetTextSize(font);
-	D2WIN_GetTextWidthFileNo(wString, &width, &fileNo);
-	D2WIN_SetTextSize(oldFont);
-	POINT point = {width, height[font]};
-	delete[] wString;
+	POINT point = {FontMetrics::GetWidth(text.c_str(), font), FontMetrics::GetHeight(font)};
 	return point;
 }
 
 POINT Texthook::GetTextSize(wchar_t* text, unsigned int font) {
-	unsigned int height[] = { 10,11,18,24,10,13,7,13,10,12,8,8,7,12 };
-	DWORD width, fileNo;
-	DWORD oldFont = D2WIN_SetTextSize(font);
-	D2WIN_GetTextWidthFileNo(text, &width, &fileNo);
-	D2WIN_SetTextSize(oldFont);
-	POINT point = { width, height[font] };
+	POINT point = { FontMetrics::GetWidth(text, font), FontMetrics::GetHeight(font) };
 	return point;
 }
 
@@ -212,29 +197,25 @@ bool Texthook::Draw(unsigned int x, unsigned int y, int align, unsigned int font
 	vsprintf_s(buffer, 4096, text.c_str(), arg);
 	va_end(arg);
 
-	//Convert multi-byte to wide character
-	wchar_t* wString = AnsiToUnicode(buffer);
+	//Convert multi-byte to wide character, measuring it only if we need to align it
+	const TextLayout* layout = TextCache::Get(buffer, font, align == Center || align == Right);
 
 	unsigned int properX = x;
 	if (align == Center)
-		x = x - (GetTextSize(buffer, font).x / 2);
+		x = x - (layout->width / 2);
 
 	if (align == Right)
-		x = x - GetTextSize(buffer, font).x;
+		x = x - layout->width;
 
-	//Draw the text!
-	unsigned int height[] = {10,11,18,24,10,13,7,13,10,12,8,8,7,12};
-	DWORD size = D2WIN_SetTextSize(font);
-	D2WIN_DrawText(wString, x, y + height[font], color, 0);
-	D2WIN_SetTextSize(size);
+	//Draw the text, or queue it if a batch is open
+	TextBatch::Draw(layout->text.c_str(), x, y + FontMetrics::GetHeight(font), font, color);
 
-	delete[] wString;
 	return true;
 }
 
 bool Texthook::Draw(unsigned int x, unsigned int y, int align, unsigned int font, TextColor color, wchar_t* text, ...) {
 	//Convert all %s's into proper values.
-	wchar_t* buffer = new wchar_t[4096];
+	wchar_t buffer[4096];
 	va_list arg;
 	va_start(arg, text);
 	vswprintf_s(buffer, 4096, text, arg);
@@ -247,12 +228,8 @@ bool Texthook::Draw(unsigned int x, unsigned int y, int align, unsigned int font
 	if (align == Right)
 		x = x - GetTextSize(buffer, font).x;
 
-	//Draw the text!
-	unsigned int height[] = { 10,11,18,24,10,13,7,13,10,12,8,8,7,12 };
-	DWORD size = D2WIN_SetTextSize(font);
-	D2WIN_DrawText(buffer, x, y + height[font], color, 0);
-	D2WIN_SetTextSize(size);
+	//Draw the text, or queue it if a batch is open
+	TextBatch::Draw(buffer, x, y + FontMetrics::GetHeight(font), font, color);
 
-	delete[] buffer;
 	return true;
 }
\ No newline at end of file
@@ -1,11 +1,188 @@
 #include "Hook.h"
 #include "Advanced/Colorhook/Colorhook.h"
 #include "../D2Ptrs.h"
+#include <algorithm>
+#include <vector>
+
+#define HIT_CELL_SIZE 64
 
 using namespace Drawing;
 using namespace std;
 
-std::list<Hook*> Hook::Hooks;
+namespace Drawing {
+	/* HookRegistry
+	 *	Holds every basic hook sorted by z-order and bucketed by visibility.
+	 *	Only changes (new hooks, removed hooks, a new z-order or visibility)
+	 *	mark it dirty, and it's re-sorted at the start of the next dispatch
+	 *	instead of on every frame and input event.
+	 *
+	 *	Dispatching only happens on the game's main thread. Hooks created
+	 *	from any thread wait in the pending list until then, so the vectors
+	 *	are never resized while something is iterating over them.
+	 *
+	 *	Clicks are hit-tested through a uniform grid over the screen, each
+	 *	cell listing the hooks that overlap it in z-order. The grid is rebuilt
+	 *	on the next click after anything a hook's bounds depend on changes.
+	 */
+	class HookRegistry {
+		private:
+			CRITICAL_SECTION crit;
+			std::vector<Hook*> pending;
+			unsigned int nextOrder;
+			int depth;
+			bool dirty;
+			std::vector<std::vector<Hook*>> cells;
+			unsigned int columns, gridWidth, gridHeight;
+			bool gridDirty;
+
+			static void Erase(std::vector<Hook*>& hooks, Hook* hook) {
+				for (auto it = hooks.begin(); it != hooks.end(); it++) {
+					if (*it == hook)
+						*it = NULL;
+				}
+			}
+
+		public:
+			std::vector<Hook*> all;
+			std::vector<Hook*> buckets[Group + 1];
+			// Hooks with no fixed bounds, visited by every click
+			std::vector<Hook*> unbounded;
+
+			static bool ZSort(Hook* one, Hook* two) {
+				if (one->z != two->z)
+					return one->z < two->z;
+				return one->order < two->order;
+			}
+
+			HookRegistry() : nextOrder(0), depth(0), dirty(false), columns(0), gridWidth(0), gridHeight(0), gridDirty(true) {
+				InitializeCriticalSection(&crit);
+			}
+
+			~HookRegistry() {
+				DeleteCriticalSection(&crit);
+			}
+
+			void Add(Hook* hook) {
+				EnterCriticalSection(&crit);
+				hook->order = nextOrder++;
+				pending.push_back(hook);
+				dirty = true;
+				LeaveCriticalSection(&crit);
+			}
+
+			// Removed hooks leave a NULL behind until the next rebuild so
+			// a dispatch in progress keeps valid indices
+			void Remove(Hook* hook) {
+				EnterCriticalSection(&crit);
+				Erase(pending, hook);
+				Erase(all, hook);
+				for (int n = 0; n <= Group; n++)
+					Erase(buckets[n], hook);
+				for (auto it = cells.begin(); it != cells.end(); it++)
+					Erase(*it, hook);
+				Erase(unbounded, hook);
+				dirty = true;
+				LeaveCriticalSection(&crit);
+			}
+
+			void Invalidate() {
+				dirty = true;
+			}
+
+			void InvalidateBounds() {
+				gridDirty = true;
+			}
+
+			void Begin() {
+				if (depth++ > 0 || !dirty)
+					return;
+
+				EnterCriticalSection(&crit);
+				dirty = false;
+				for (auto it = pending.begin(); it != pending.end(); it++) {
+					if (*it)
+						all.push_back(*it);
+				}
+				pending.clear();
+				all.erase(std::remove(all.begin(), all.end(), (Hook*)NULL), all.end());
+				std::sort(all.begin(), all.end(), ZSort);
+
+				for (int n = 0; n <= Group; n++)
+					buckets[n].clear();
+				for (auto it = all.begin(); it != all.end(); it++)
+					buckets[(*it)->visibility].push_back(*it);
+				gridDirty = true;
+				LeaveCriticalSection(&crit);
+			}
+
+			// Returns the hooks whose bounds contain the point, must be called between Begin and End
+			std::vector<Hook*>& Locate(unsigned int x, unsigned int y) {
+				static std::vector<Hook*> none;
+				// Only rebuild from the outermost dispatch, a nested one may be iterating a cell
+				if (depth == 1 && (gridDirty || gridWidth != Hook::GetScreenWidth() || gridHeight != Hook::GetScreenHeight()))
+					BuildGrid();
+				if (x >= gridWidth || y >= gridHeight)
+					return none;
+				return cells[(y / HIT_CELL_SIZE) * columns + (x / HIT_CELL_SIZE)];
+			}
+
+			void BuildGrid() {
+				gridDirty = false;
+				gridWidth = Hook::GetScreenWidth();
+				gridHeight = Hook::GetScreenHeight();
+				columns = (gridWidth + HIT_CELL_SIZE - 1) / HIT_CELL_SIZE;
+				unsigned int rows = (gridHeight + HIT_CELL_SIZE - 1) / HIT_CELL_SIZE;
+				cells.assign(columns * rows, std::vector<Hook*>());
+				unbounded.clear();
+
+				for (auto it = all.begin(); it != all.end(); it++) {
+					Hook* hook = *it;
+					if (!hook)
+						continue;
+					// Automap hooks move with the map every frame
+					if (hook->visibility == Automap || hook->HitTestAlways()) {
+						unbounded.push_back(hook);
+						continue;
+					}
+
+					// Same bounds as InRange, hooks starting off screen can never be clicked
+					unsigned int left = hook->GetX(), top = hook->GetY();
+					if (left >= gridWidth || top >= gridHeight)
+						continue;
+					unsigned int right = left + hook->GetXSize(), bottom = top + hook->GetYSize();
+					right = min(right, gridWidth - 1);
+					bottom = min(bottom, gridHeight - 1);
+					for (unsigned int row = top / HIT_CELL_SIZE; row <= bottom / HIT_CELL_SIZE; row++) {
+						for (unsigned int column = left / HIT_CELL_SIZE; column <= right / HIT_CELL_SIZE; column++)
+							cells[row * columns + column].push_back(hook);
+					}
+				}
+			}
+
+			// Visits the hooks of two z-sorted lists in their combined z-order
+			template <typename F>
+			static void Merge(std::vector<Hook*>& one, std::vector<Hook*>& two, F visit) {
+				size_t i = 0, j = 0;
+				while (i < one.size() || j < two.size()) {
+					if (i < one.size() && !one[i]) {
+						i++;
+					} else if (j < two.size() && !two[j]) {
+						j++;
+					} else if (j >= two.size() || (i < one.size() && ZSort(one[i], two[j]))) {
+						visit(one[i++]);
+					} else {
+						visit(two[j++]);
+					}
+				}
+			}
+
+			void End() {
+				depth--;
+			}
+	};
+}
+
+static HookRegistry registry;
 
 /* Basic Hook Initializer
  *		Used for just drawing basic things on screen.
@@ -13,7 +190,7 @@ std::list<Hook*> Hook::Hooks;
 Hook::Hook(HookVisibility visibility, unsigned int x, unsigned int y) : 
 visibility(visibility), x(x), y(y), z(1), active(true), alignment(None), group(false), left(false), right(false), leftVoid(false), rightVoid(false) {
 	InitializeCriticalSection(&crit);
-	Hooks.push_back(this);
+	registry.Add(this);
 }
 
 /* Group Hook Initializer
@@ -22,10 +199,28 @@ visibility(visibility), x(x), y(y), z(1), active(true), alignment(None), group(f
 Hook::Hook(HookGroup *group, unsigned int x, unsigned int y) :
 visibility(Group), x(x), y(y), z(1), active(true), alignment(None), group(group), left(false), right(false), leftVoid(false), rightVoid(false) {
 	InitializeCriticalSection(&crit);
-	Hooks.push_back(this);
+	registry.Add(this);
 	group->Hooks.push_back(this);
 }
 
+/* BoundsChanged()
+ *	Tells click dispatch to re-read hook bounds, for changes made outside
+ *	of the hook itself like moving its group or changing its text.
+ */
+void Hook::BoundsChanged() {
+	registry.InvalidateBounds();
+}
+
+/* Hook Destructor
+ *		Removes the hook from the registry and its group.
+ */
+Hook::~Hook() {
+	registry.Remove(this);
+	if (group)
+		group->Hooks.remove(this);
+	DeleteCriticalSection(&crit);
+}
+
 /* Lock()
  *	Locks Critical Section so we can do work.
  */
@@ -77,6 +272,7 @@ void Hook::SetBaseX(unsigned int xPos) {
 	Lock();
 	x = xPos;
 	Unlock();
+	registry.InvalidateBounds();
 }
 
 /* GetBaseX()
@@ -114,6 +310,7 @@ void Hook::SetBaseY(unsigned int yPos) {
 	Lock();
 	y = yPos;
 	Unlock();
+	registry.InvalidateBounds();
 }
 
 /* GetBaseY()
@@ -139,6 +336,7 @@ void Hook::SetZOrder(int zPos) {
 	Lock();
 	z = zPos;
 	Unlock();
+	registry.Invalidate();
 }
 
 /* GetVisibility()
@@ -155,6 +353,7 @@ void Hook::SetVisibility(HookVisibility newVisibility) {
 	Lock();
 	visibility = newVisibility;
 	Unlock();
+	registry.Invalidate();
 }
 
 /* IsActive()
@@ -187,6 +386,7 @@ void Hook::SetAlignment(int newAlign) {
 	Lock();
 	alignment = newAlign;
 	Unlock();
+	registry.InvalidateBounds();
 }
 
 /* GetGroup()
@@ -203,6 +403,7 @@ void Hook::SetGroup(HookGroup* newGroup) {
 	Lock();
 	group = newGroup;
 	Unlock();
+	registry.InvalidateBounds();
 }
 
 /* GetLeftClickHandler()
@@ -300,25 +501,16 @@ void Hook::AutomapToScreen(POINT* ptPos, int x, int y) {
 	D2COMMON_MapToAbsScreen(&ptPos->x, &ptPos->y);
 }
 
-/* ZSort
- *	Compares hook Z Orders
- */
-bool ZSort (Hook* one, Hook* two) {
-	return one->GetZOrder() < two->GetZOrder();
-}
-
 /* Hook::Draw(HookVisibility type)
  *	Called by Handlers to draw appropirate hooks
  */
 void Hook::Draw(HookVisibility type) {
-	if (type != Drawing::OutOfGame) {
-		// The Z order of the hooks doesn't get changed while OOG, so there's
-		// no need to repeatedly sort them
-		Hooks.sort(ZSort);
-	}
-	for (HookIterator it = Hooks.begin(); it!=Hooks.end(); ++it)
-		if ((*it)->GetVisibility() == type || (*it)->GetVisibility() == Perm)
-			(*it)->OnDraw();
+	registry.Begin();
+	// Both buckets are sorted, merge them so permanent hooks keep their place in the z-order
+	static std::vector<Hook*> none;
+	std::vector<Hook*>& perm = (type == Perm) ? none : registry.buckets[Perm];
+	HookRegistry::Merge(registry.buckets[type], perm, [](Hook* hook) { hook->OnDraw(); });
+	registry.End();
 	if (Colorhook::current) {
 		Colorhook::current->OnDraw();
 		return;
@@ -329,16 +521,17 @@ void Hook::Draw(HookVisibility type) {
  *	Calls the Left Click handlers and blocks click if needed.
  */
 bool Hook::LeftClick(bool up, unsigned int x, unsigned int y) {
-	Hooks.sort(ZSort);
 	bool block = false;
 	if (Colorhook::current) {
 		Colorhook::current->OnLeftClick(up, x, y);
 		return true;
 	}
-	for (list<Hook*>::iterator it = Hooks.begin(); it!=Hooks.end(); ++it)
-		if ((*it)->IsActive())
-			if ((*it)->OnLeftClick(up, x, y))
-				block = true;
+	registry.Begin();
+	HookRegistry::Merge(registry.Locate(x, y), registry.unbounded, [&](Hook* hook) {
+		if (hook->IsActive() && hook->OnLeftClick(up, x, y))
+			block = true;
+	});
+	registry.End();
 	return block;
 }
 
@@ -346,16 +539,17 @@ bool Hook::LeftClick(bool up, unsigned int x, unsigned int y) {
  *	Calls the Right Click handlers and blocks click if needed.
  */
 bool Hook::RightClick(bool up, unsigned int x, unsigned int y) {
-	Hooks.sort(ZSort);
 	bool block = false;
 	if (Colorhook::current) {
 		Colorhook::current->OnRightClick(up, x, y);
 		return true;
 	}
-	for (HookIterator it = Hooks.begin(); it!=Hooks.end(); ++it)
-		if ((*it)->IsActive())
-			if ((*it)->OnRightClick(up, x, y))
-				block = true;
+	registry.Begin();
+	HookRegistry::Merge(registry.Locate(x, y), registry.unbounded, [&](Hook* hook) {
+		if (hook->IsActive() && hook->OnRightClick(up, x, y))
+			block = true;
+	});
+	registry.End();
 	return block;
 }
 
@@ -363,11 +557,12 @@ bool Hook::RightClick(bool up, unsigned int x, unsigned int y) {
  *	Calls the Key Click handlers and blocks click if needed.
  */
 bool Hook::KeyClick(bool bUp, BYTE bKey, LPARAM lParam) {
-	Hooks.sort(ZSort);
 	bool block = false;
-	for (HookIterator it = Hooks.begin(); it!=Hooks.end(); ++it)
-		if ((*it)->IsActive())
-			if ((*it)->OnKey(bUp, bKey, lParam))
+	registry.Begin();
+	for (size_t n = 0; n < registry.all.size(); n++)
+		if (registry.all[n] && registry.all[n]->IsActive())
+			if (registry.all[n]->OnKey(bUp, bKey, lParam))
 				block = true;
+	registry.End();
 	return block;
 }
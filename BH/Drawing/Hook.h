@@ -29,9 +29,10 @@ namespace Drawing {
 
 	class Hook {
 		private:
-			static HookList Hooks;//Holds a list of every basic hook used.
+			friend class HookRegistry;
 			HookVisibility visibility;//When we should show the hook.
 			unsigned int x, y, z;//Hooks screen coordinates and the z-order.
+			unsigned int order;//Registration order, breaks ties between equal z-orders.
 			CRITICAL_SECTION crit;//Critical Section so we don't have race conditions.
 			bool active;//Boolean to hold if we should draw the hook or not.
 			int alignment;//Holds what type of alignment(if any) we should use.
@@ -44,7 +45,7 @@ namespace Drawing {
 			//Two Hook Initializations; one for basic hooks, one for grouped hooks.
 			Hook(HookVisibility visibility, unsigned int x, unsigned int y);
 			Hook(HookGroup* group, unsigned int x, unsigned int y);
-			//~Hook();
+			virtual ~Hook();
 
 			//Critical Section Helpers.
 			void Lock();
@@ -132,6 +133,12 @@ namespace Drawing {
 			//Determine if the given x/y set is within the hooks drawing area.
 			bool InRange(unsigned int x, unsigned int y);
 
+			//Return true if the hook handles clicks outside of its bounds, so click dispatch can't skip it.
+			virtual bool HitTestAlways() { return false; };
+
+			//Call when a hook's bounds change without going through its setters.
+			static void BoundsChanged();
+
 			//This is the function in super-class we actually draw the function.
 			virtual void OnDraw() = 0;
 
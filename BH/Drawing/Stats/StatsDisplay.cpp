@@ -2,6 +2,7 @@
 #include "../Basic/Texthook/Texthook.h"
 #include "../Basic/Framehook/Framehook.h"
 #include "../Basic/Boxhook/Boxhook.h"
+#include "../Basic/Texthook/FontMetrics.h"
 #include "../../D2Ptrs.h"
 #include "../../BH.h"
 
@@ -14,6 +15,7 @@ StatsDisplay::StatsDisplay(std::string name) {
 	int width = 240;
 
 	InitializeCriticalSection(&crit);
+	lineCount = 0;
 	SetY(yPos);
 	SetXSize(width);
 
@@ -40,6 +42,7 @@ StatsDisplay::~StatsDisplay() {
 void StatsDisplay::LoadConfig(){
 	int height = 342 + 8 * 3 + 16 * 5;
 	customStats.clear();
+	lines.clear();
 
 	BH::config->ReadToggle("Stats on Right", "None", false, Toggles["Stats on Right"]);
 
@@ -79,6 +82,7 @@ void StatsDisplay::SetX(unsigned int newX) {
 		Lock();
 		x = newX;
 		Unlock();
+		Hook::BoundsChanged();
 	}
 }
 
@@ -87,6 +91,7 @@ void StatsDisplay::SetY(unsigned int newY) {
 		Lock();
 		y = newY;
 		Unlock();
+		Hook::BoundsChanged();
 	}
 }
 
@@ -144,15 +149,26 @@ void StatsDisplay::OnDraw() {
 		Drawing::Boxhook::Draw(GetX(),GetY(), GetXSize(), GetYSize(), White, Drawing::BTBlack);
 		Drawing::Framehook::DrawRectStub(&pRect);
 
-		Texthook::Draw(column1, (y += 8), None, 6, Gold,
-				"Name:c0 %s",
-				isMerc ? "c;Mercenary" : unit->pPlayerData->szName);
-		Texthook::Draw(pRect.right - 5, y, Right, 6, Gold,
-				L"Level:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_LEVEL, 0));
-		Texthook::Draw(pRect.right - 5, y + 12, Right, 6, Gold,
-				L"Additional XP:c: %d%%",
-				(int)D2COMMON_GetUnitStat(unit, STAT_ADDEXPERIENCE, 0));
+		// Every line is drawn in the same font, so set it once for the whole panel
+		lineCount = 0;
+		DWORD size = D2WIN_SetTextSize(STAT_FONT);
+
+		StatLine *line = &NextLine();
+		if (line->Changed({ isMerc, (int)unit->dwUnitId }))
+			line->Format("Name:c0 %s", isMerc ? "c;Mercenary" : unit->pPlayerData->szName);
+		line->Draw(column1, (y += 8), None, Gold);
+
+		int level = (int)D2COMMON_GetUnitStat(unit, STAT_LEVEL, 0);
+		line = &NextLine();
+		if (line->Changed({ level }))
+			line->Format(L"Level:c0 %d", level);
+		line->Draw(pRect.right - 5, y, Right, Gold);
+
+		int addExp = (int)D2COMMON_GetUnitStat(unit, STAT_ADDEXPERIENCE, 0);
+		line = &NextLine();
+		if (line->Changed({ addExp }))
+			line->Format(L"Additional XP:c: %d%%", addExp);
+		line->Draw(pRect.right - 5, y + 12, Right, Gold);
 
 		y += 8;
 
@@ -160,21 +176,32 @@ void StatsDisplay::OnDraw() {
 		int xPacMultiplier = pData->nCharFlags & PLAYER_TYPE_EXPANSION ? 2 : 1;
 		int resPenalty[3] = { RES_PENALTY_CLS_NORM, RES_PENALTY_CLS_NM, RES_PENALTY_CLS_HELL };
 		int penalty = resPenalty[D2CLIENT_GetDifficulty()] * xPacMultiplier;
+		int fRes = (int)D2COMMON_GetUnitStat(unit, STAT_FIRERESIST, 0) + penalty;
+		int cRes = (int)D2COMMON_GetUnitStat(unit, STAT_COLDRESIST, 0) + penalty;
+		int lRes = (int)D2COMMON_GetUnitStat(unit, STAT_LIGHTNINGRESIST, 0) + penalty;
+		int pRes = (int)D2COMMON_GetUnitStat(unit, STAT_POISONRESIST, 0) + penalty;
 		int fMax = (int)D2COMMON_GetUnitStat(unit, STAT_MAXFIRERESIST, 0) + 75;
 		int cMax = (int)D2COMMON_GetUnitStat(unit, STAT_MAXCOLDRESIST, 0) + 75;
 		int lMax = (int)D2COMMON_GetUnitStat(unit, STAT_MAXLIGHTNINGRESIST, 0) + 75;
 		int pMax = (int)D2COMMON_GetUnitStat(unit, STAT_MAXPOISONRESIST, 0) + 75;
 		int pLengthReduce = (int)D2COMMON_GetUnitStat(unit, STAT_POISONLENGTHREDUCTION, 0);
 
-		Texthook::Draw(column1, (y += 16), None, 6, Red, L"c4Fire Resist:c1 %d c0/ %d", (int)D2COMMON_GetUnitStat(unit, STAT_FIRERESIST, 0) + penalty, fMax);
-		Texthook::Draw(column1, (y += 16), None, 6, Blue, L"c4Cold Resist:c3 %d c0/ %d", (int)D2COMMON_GetUnitStat(unit, STAT_COLDRESIST, 0) + penalty, cMax);
-		Texthook::Draw(column1, (y += 16), None, 6, Yellow, L"c4Lightning Resist:c9 %d c0/ %d", (int)D2COMMON_GetUnitStat(unit, STAT_LIGHTNINGRESIST, 0) + penalty, lMax);
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Poison Resist:c2 %d c0/ %d  c4Length:c: %d%%",
-				(int)D2COMMON_GetUnitStat(unit, STAT_POISONRESIST, 0) + penalty,
-				pMax,
-				(100 - penalty - pLengthReduce)
-				);
+		line = &NextLine();
+		if (line->Changed({ fRes, fMax }))
+			line->Format(L"c4Fire Resist:c1 %d c0/ %d", fRes, fMax);
+		line->Draw(column1, (y += 16), None, Red);
+		line = &NextLine();
+		if (line->Changed({ cRes, cMax }))
+			line->Format(L"c4Cold Resist:c3 %d c0/ %d", cRes, cMax);
+		line->Draw(column1, (y += 16), None, Blue);
+		line = &NextLine();
+		if (line->Changed({ lRes, lMax }))
+			line->Format(L"c4Lightning Resist:c9 %d c0/ %d", lRes, lMax);
+		line->Draw(column1, (y += 16), None, Yellow);
+		line = &NextLine();
+		if (line->Changed({ pRes, pMax, penalty, pLengthReduce }))
+			line->Format(L"Poison Resist:c2 %d c0/ %d  c4Length:c: %d%%", pRes, pMax, (100 - penalty - pLengthReduce));
+		line->Draw(column1, (y += 16), None, Gold);
 		y += 8;
 
 		int fAbsorb = (int)D2COMMON_GetUnitStat(unit, STAT_FIREABSORB, 0);
@@ -185,13 +212,19 @@ void StatsDisplay::OnDraw() {
 		int lAbsorbPct = (int)D2COMMON_GetUnitStat(unit, STAT_LIGHTNINGABSORBPERCENT, 0);
 		int mAbsorb = (int)D2COMMON_GetUnitStat(unit, STAT_MAGICABSORB, 0);
 		int mAbsorbPct = (int)D2COMMON_GetUnitStat(unit, STAT_MAGICABSORBPERCENT, 0);
-		Texthook::Draw(column1, (y += 16), None, 6, Red, L"c4Absorption: c1%dc0/c1%d%c c3%dc0/c3%d%c c9%dc0/c9%d%c c8%dc0/c8%d%c", fAbsorb, fAbsorbPct, '%', cAbsorb, cAbsorbPct, '%', lAbsorb, lAbsorbPct, '%', mAbsorb, mAbsorbPct, '%');
+		line = &NextLine();
+		if (line->Changed({ fAbsorb, fAbsorbPct, cAbsorb, cAbsorbPct, lAbsorb, lAbsorbPct, mAbsorb, mAbsorbPct }))
+			line->Format(L"c4Absorption: c1%dc0/c1%d%c c3%dc0/c3%d%c c9%dc0/c9%d%c c8%dc0/c8%d%c", fAbsorb, fAbsorbPct, '%', cAbsorb, cAbsorbPct, '%', lAbsorb, lAbsorbPct, '%', mAbsorb, mAbsorbPct, '%');
+		line->Draw(column1, (y += 16), None, Red);
 
 		int dmgReduction = (int)D2COMMON_GetUnitStat(unit, STAT_DMGREDUCTION, 0);
 		int dmgReductionPct = (int)D2COMMON_GetUnitStat(unit, STAT_DMGREDUCTIONPCT, 0);
 		int magReduction = (int)D2COMMON_GetUnitStat(unit, STAT_MAGICDMGREDUCTION, 0);
 		int magReductionPct = (int)D2COMMON_GetUnitStat(unit, STAT_MAGICDMGREDUCTIONPCT, 0);
-		Texthook::Draw(column1, (y += 16), None, 6, Tan, L"c4Damage Reduction: c7%dc0/c7%d%c c8%dc0/c8%d%c", dmgReduction, dmgReductionPct, '%', magReduction, magReductionPct, '%');
+		line = &NextLine();
+		if (line->Changed({ dmgReduction, dmgReductionPct, magReduction, magReductionPct }))
+			line->Format(L"c4Damage Reduction: c7%dc0/c7%d%c c8%dc0/c8%d%c", dmgReduction, dmgReductionPct, '%', magReduction, magReductionPct, '%');
+		line->Draw(column1, (y += 16), None, Tan);
 		y += 8;
 
 		int fMastery = (int)D2COMMON_GetUnitStat(unit, STAT_FIREMASTERY, 0);
@@ -205,85 +238,70 @@ void StatsDisplay::OnDraw() {
 		int lPierce = (int)D2COMMON_GetUnitStat(unit, STAT_PSENEMYLIGHTNRESREDUC, 0);
 		int pPierce = (int)D2COMMON_GetUnitStat(unit, STAT_PSENEMYPSNRESREDUC, 0);
 		int mPierce = (int)D2COMMON_GetUnitStat(unit, STAT_PASSIVEMAGICRESREDUC, 0);
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Elemental Mastery:c1 %d%%c3 %d%%c9 %d%%c2 %d%%c8 %d%%",
-				fMastery, cMastery, lMastery, pMastery, mMastery);
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Elemental Pierce:c1 %d%%c3 %d%%c9 %d%%c2 %d%%c8 %d%%",
-				fPierce, cPierce, lPierce, pPierce, mPierce);
+		line = &NextLine();
+		if (line->Changed({ fMastery, cMastery, lMastery, pMastery, mMastery }))
+			line->Format(L"Elemental Mastery:c1 %d%%c3 %d%%c9 %d%%c2 %d%%c8 %d%%",
+					fMastery, cMastery, lMastery, pMastery, mMastery);
+		line->Draw(column1, (y += 16), None, Gold);
+		line = &NextLine();
+		if (line->Changed({ fPierce, cPierce, lPierce, pPierce, mPierce }))
+			line->Format(L"Elemental Pierce:c1 %d%%c3 %d%%c9 %d%%c2 %d%%c8 %d%%",
+					fPierce, cPierce, lPierce, pPierce, mPierce);
+		line->Draw(column1, (y += 16), None, Gold);
+
 		int classNum = pData->nCharClass;
 		auto classArMod = CharList[classNum]->toHitFactor - 35;
-		int dexAR = (int)D2COMMON_GetUnitStat(unit, STAT_DEXTERITY, 0) * 5 + classArMod;
+		int dexterity = (int)D2COMMON_GetUnitStat(unit, STAT_DEXTERITY, 0);
+		int dexAR = dexterity * 5 + classArMod;
 		int gearAR = (int)D2COMMON_GetUnitStat(unit, STAT_ATTACKRATING, 0);
-
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Base AR:c5 dex:c0 %dc5 equip:c0% dc5 total:c0 %d",
-				dexAR, gearAR, dexAR + gearAR);
+		line = &NextLine();
+		if (line->Changed({ dexAR, gearAR }))
+			line->Format(L"Base AR:c5 dex:c0 %dc5 equip:c0% dc5 total:c0 %d",
+					dexAR, gearAR, dexAR + gearAR);
+		line->Draw(column1, (y += 16), None, Gold);
 
 		int gearDef = (int)D2COMMON_GetUnitStat(unit, STAT_DEFENSE, 0);
-		int dexDef = (int)D2COMMON_GetUnitStat(unit, STAT_DEXTERITY, 0) / 4;
-		
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Base Def:c5 dex:c0 %dc5 equip:c0 %dc5 total:c0 %d",
-				dexDef, gearDef, dexDef + gearDef);
-
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Base Damage:c5 1h:c0 %d-%dc5 2h:c0 %d-%d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_MINIMUMDAMAGE, 0),
-				(int)D2COMMON_GetUnitStat(unit, STAT_MAXIMUMDAMAGE, 0),
-				(int)D2COMMON_GetUnitStat(unit, STAT_SECONDARYMINIMUMDAMAGE, 0),
-				(int)D2COMMON_GetUnitStat(unit, STAT_SECONDARYMAXIMUMDAMAGE, 0));
+		int dexDef = dexterity / 4;
+		line = &NextLine();
+		if (line->Changed({ dexDef, gearDef }))
+			line->Format(L"Base Def:c5 dex:c0 %dc5 equip:c0 %dc5 total:c0 %d",
+					dexDef, gearDef, dexDef + gearDef);
+		line->Draw(column1, (y += 16), None, Gold);
+
+		int minDamage = (int)D2COMMON_GetUnitStat(unit, STAT_MINIMUMDAMAGE, 0);
+		int maxDamage = (int)D2COMMON_GetUnitStat(unit, STAT_MAXIMUMDAMAGE, 0);
+		int minDamage2h = (int)D2COMMON_GetUnitStat(unit, STAT_SECONDARYMINIMUMDAMAGE, 0);
+		int maxDamage2h = (int)D2COMMON_GetUnitStat(unit, STAT_SECONDARYMAXIMUMDAMAGE, 0);
+		line = &NextLine();
+		if (line->Changed({ minDamage, maxDamage, minDamage2h, maxDamage2h }))
+			line->Format(L"Base Damage:c5 1h:c0 %d-%dc5 2h:c0 %d-%d",
+					minDamage, maxDamage, minDamage2h, maxDamage2h);
+		line->Draw(column1, (y += 16), None, Gold);
 
 		y += 8;
 
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Cast Rate:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_FASTERCAST, 0)
-				);
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"Block Rate:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_FASTERBLOCK, 0)
-				);
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Hit Recovery:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_FASTERHITRECOVERY, 0)
-				);
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"Run/Walk:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_FASTERRUNWALK, 0)
-				);
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Attack Rate:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_ATTACKRATE, 0));
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"IAS:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_IAS, 0));
+		DrawStatLine(unit, column1, (y += 16), L"Cast Rate:c0 %d", STAT_FASTERCAST);
+		DrawStatLine(unit, column2, y, L"Block Rate:c0 %d", STAT_FASTERBLOCK);
+		DrawStatLine(unit, column1, (y += 16), L"Hit Recovery:c0 %d", STAT_FASTERHITRECOVERY);
+		DrawStatLine(unit, column2, y, L"Run/Walk:c0 %d", STAT_FASTERRUNWALK);
+		DrawStatLine(unit, column1, (y += 16), L"Attack Rate:c0 %d", STAT_ATTACKRATE);
+		DrawStatLine(unit, column2, y, L"IAS:c0 %d", STAT_IAS);
 
 		y += 8;
 
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Crushing Blow:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_CRUSHINGBLOW, 0));
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"Open Wounds: c0%d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_OPENWOUNDS, 0));
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Deadly Strike:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_DEADLYSTRIKE, 0));
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"Critical Strike: c0%d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_CRITICALSTRIKE, 0));
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Life Leech:c1 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_LIFELEECH, 0));
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"Mana Leech:c3 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_MANALEECH, 0));
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Projectile Pierce:c0 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_PIERCINGATTACK, 0) +
-				(int)D2COMMON_GetUnitStat(unit, STAT_PIERCE, 0)
-				);
+		DrawStatLine(unit, column1, (y += 16), L"Crushing Blow:c0 %d", STAT_CRUSHINGBLOW);
+		DrawStatLine(unit, column2, y, L"Open Wounds: c0%d", STAT_OPENWOUNDS);
+		DrawStatLine(unit, column1, (y += 16), L"Deadly Strike:c0 %d", STAT_DEADLYSTRIKE);
+		DrawStatLine(unit, column2, y, L"Critical Strike: c0%d", STAT_CRITICALSTRIKE);
+		DrawStatLine(unit, column1, (y += 16), L"Life Leech:c1 %d", STAT_LIFELEECH);
+		DrawStatLine(unit, column2, y, L"Mana Leech:c3 %d", STAT_MANALEECH);
+
+		int pierce = (int)D2COMMON_GetUnitStat(unit, STAT_PIERCINGATTACK, 0) +
+			(int)D2COMMON_GetUnitStat(unit, STAT_PIERCE, 0);
+		line = &NextLine();
+		if (line->Changed({ pierce }))
+			line->Format(L"Projectile Pierce:c0 %d", pierce);
+		line->Draw(column1, (y += 16), None, Gold);
 
 		y += 8;
 
@@ -303,62 +321,121 @@ void StatsDisplay::OnDraw() {
 		int minMagic = (int)D2COMMON_GetUnitStat(unit, STAT_MINIMUMMAGICALDAMAGE, 0);
 		int maxMagic = (int)D2COMMON_GetUnitStat(unit, STAT_MAXIMUMMAGICALDAMAGE, 0);
 		int addedPhys = (int)D2COMMON_GetUnitStat(unit, STAT_ADDSDAMAGE, 0);
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Added Damage:c0 %d",
-				addedPhys);
-		Texthook::Draw(column2, y, None, 6, Orange,
-				"%d-%d",
-				minMagic, maxMagic);
-		Texthook::Draw(column1, (y += 16), None, 6, Red,
-				"%d-%d",
-				minFire, maxFire);
-		Texthook::Draw(column2, y, None, 6, Blue,
-				"%d-%d",
-				minCold, maxCold);
-		Texthook::Draw(column1, (y += 16), None, 6, Yellow,
-				"%d-%d",
-				minLight, maxLight);
-		Texthook::Draw(column2, y, None, 6, Green,
-				"%d-%d over %.1fs",
-				(int)(minPoison / 256.0 * poisonLength),
-				(int)(maxPoison / 256.0 * poisonLength),
-				poisonLength / 25.0);
+		line = &NextLine();
+		if (line->Changed({ addedPhys }))
+			line->Format(L"Added Damage:c0 %d", addedPhys);
+		line->Draw(column1, (y += 16), None, Gold);
+		line = &NextLine();
+		if (line->Changed({ minMagic, maxMagic }))
+			line->Format(L"%d-%d", minMagic, maxMagic);
+		line->Draw(column2, y, None, Orange);
+		line = &NextLine();
+		if (line->Changed({ minFire, maxFire }))
+			line->Format(L"%d-%d", minFire, maxFire);
+		line->Draw(column1, (y += 16), None, Red);
+		line = &NextLine();
+		if (line->Changed({ minCold, maxCold }))
+			line->Format(L"%d-%d", minCold, maxCold);
+		line->Draw(column2, y, None, Blue);
+		line = &NextLine();
+		if (line->Changed({ minLight, maxLight }))
+			line->Format(L"%d-%d", minLight, maxLight);
+		line->Draw(column1, (y += 16), None, Yellow);
+		line = &NextLine();
+		if (line->Changed({ minPoison, maxPoison, poisonLength }))
+			line->Format(L"%d-%d over %.1fs",
+					(int)(minPoison / 256.0 * poisonLength),
+					(int)(maxPoison / 256.0 * poisonLength),
+					poisonLength / 25.0);
+		line->Draw(column2, y, None, Green);
 
 		y += 8;
 
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Magic Find:c3 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_MAGICFIND, 0)
-				);
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"Gold Find:c9 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_GOLDFIND, 0));
-
-		Texthook::Draw(column1, (y += 16), None, 6, Gold,
-				L"Stash Gold:c9 %d",
-				(int)D2COMMON_GetUnitStat(unit, STAT_GOLDBANK, 0));
+		DrawStatLine(unit, column1, (y += 16), L"Magic Find:c3 %d", STAT_MAGICFIND);
+		DrawStatLine(unit, column2, y, L"Gold Find:c9 %d", STAT_GOLDFIND);
+		DrawStatLine(unit, column1, (y += 16), L"Stash Gold:c9 %d", STAT_GOLDBANK);
 
 		int cowKingKilled = D2COMMON_GetQuestFlag(D2CLIENT_GetQuestInfo(), 4, 10);
-		Texthook::Draw(column2, y, None, 6, Gold,
-				L"Cow King:c0 %s", cowKingKilled ? L"killed" : L"alive");
+		line = &NextLine();
+		if (line->Changed({ cowKingKilled }))
+			line->Format(L"Cow King:c0 %s", cowKingKilled ? L"killed" : L"alive");
+		line->Draw(column2, y, None, Gold);
 
 		if (customStats.size() > 0) {
 			y += 8;
 			for (unsigned int i = 0; i < customStats.size(); i++) {
 				int secondary = customStats[i]->useValue ? customStats[i]->value : 0;
 				int stat = (int)D2COMMON_GetUnitStat(unit, STAT_NUMBER(customStats[i]->name), secondary);
-				if (secondary > 0) {
-					Texthook::Draw(column1, (y += 16), None, 6, Gold, "%s[%d]:c0 %d",
-							customStats[i]->name.c_str(), secondary, stat);
-				} else {
-					Texthook::Draw(column1, (y += 16), None, 6, Gold, "%s:c0 %d",
-							customStats[i]->name.c_str(), stat);
+				line = &NextLine();
+				if (line->Changed({ secondary, stat })) {
+					if (secondary > 0) {
+						line->Format("%s[%d]:c0 %d", customStats[i]->name.c_str(), secondary, stat);
+					} else {
+						line->Format("%s:c0 %d", customStats[i]->name.c_str(), stat);
+					}
 				}
+				line->Draw(column1, (y += 16), None, Gold);
 			}
 		}
+
+		D2WIN_SetTextSize(size);
 	}
 }
 
+StatLine& StatsDisplay::NextLine() {
+	if (lineCount >= lines.size())
+		lines.resize(lineCount + 1);
+	return lines[lineCount++];
+}
+
+void StatsDisplay::DrawStatLine(UnitAny *unit, unsigned int x, unsigned int y, const wchar_t *format, int stat) {
+	int value = (int)D2COMMON_GetUnitStat(unit, stat, 0);
+	StatLine &line = NextLine();
+	if (line.Changed({ value }))
+		line.Format(format, value);
+	line.Draw(x, y, None, Gold);
+}
+
+bool StatLine::Changed(std::initializer_list<int> values) {
+	if (formatted && inputs.size() == values.size() && std::equal(values.begin(), values.end(), inputs.begin()))
+		return false;
+	inputs.assign(values.begin(), values.end());
+	return true;
+}
+
+void StatLine::Format(const char *format, ...) {
+	char buffer[1024];
+	va_list arg;
+	va_start(arg, format);
+	vsprintf_s(buffer, 1024, format, arg);
+	va_end(arg);
+
+	wchar_t wBuffer[1024];
+	MultiByteToWideChar(CODE_PAGE, 0, buffer, -1, wBuffer, 1024);
+	text = wBuffer;
+	width = FontMetrics::GetWidth(wBuffer, STAT_FONT);
+	formatted = true;
+}
+
+void StatLine::Format(const wchar_t *format, ...) {
+	wchar_t buffer[1024];
+	va_list arg;
+	va_start(arg, format);
+	vswprintf_s(buffer, 1024, format, arg);
+	va_end(arg);
+
+	text = buffer;
+	width = FontMetrics::GetWidth(buffer, STAT_FONT);
+	formatted = true;
+}
+
+// Expects the font to already be set to STAT_FONT
+void StatLine::Draw(unsigned int x, unsigned int y, int align, TextColor color) {
+	if (align == Right)
+		x -= width;
+	D2WIN_DrawText((wchar_t*)text.c_str(), x, y + FontMetrics::GetHeight(STAT_FONT), color, 0);
+}
+
 bool StatsDisplay::KeyClick(bool bUp, BYTE bKey, LPARAM lParam) {
 	display->Lock();
 	bool block = display->OnKey(bUp, bKey, lParam);
@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <string>
 #include <list>
+#include <vector>
+#include <initializer_list>
 #include "../Hook.h"
 #include "../../MPQInit.h"
 #include "../../Drawing.h"
@@ -15,9 +17,30 @@ struct DisplayedStat {
 	bool useValue;
 };
 
+#define STAT_FONT 6
+
 namespace Drawing {
 	class StatsDisplay;
 
+	// One line of the stats panel. The wide string and its width are kept
+	// between frames and only re-formatted when one of the line's inputs changes.
+	class StatLine {
+		private:
+			std::vector<int> inputs;
+			std::wstring text;
+			unsigned int width;
+			bool formatted;
+		public:
+			StatLine() : width(0), formatted(false) {};
+
+			// Stores the values the line is built from, returns true if they differ from last frame
+			bool Changed(std::initializer_list<int> values);
+
+			void Format(const char *format, ...);
+			void Format(const wchar_t *format, ...);
+			void Draw(unsigned int x, unsigned int y, int align, TextColor color);
+	};
+
 	class StatsDisplay : public HookGroup {
 		private:
 			std::map<std::string, Toggle> Toggles;
@@ -28,6 +51,11 @@ namespace Drawing {
 			bool active, minimized;
 			CRITICAL_SECTION crit;
 			std::vector<DisplayedStat*> customStats;
+			std::vector<StatLine> lines;
+			unsigned int lineCount;
+
+			StatLine& NextLine();
+			void DrawStatLine(UnitAny *unit, unsigned int x, unsigned int y, const wchar_t *format, int stat);
 		public:
 			StatsDisplay(std::string name);
 			~StatsDisplay();
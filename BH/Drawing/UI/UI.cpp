@@ -61,6 +61,7 @@ void UI::SetX(unsigned int newX) {
 		Lock();
 		x = newX;
 		Unlock();
+		Hook::BoundsChanged();
 	}
 }
 
@@ -69,6 +70,7 @@ void UI::SetY(unsigned int newY) {
 		Lock();
 		y = newY;
 		Unlock();
+		Hook::BoundsChanged();
 	}
 }
 
@@ -77,6 +79,7 @@ void UI::SetXSize(unsigned int newXSize) {
 		Lock();
 		xSize = newXSize;
 		Unlock();
+		Hook::BoundsChanged();
 	}
 }
 
@@ -85,6 +88,7 @@ void UI::SetYSize(unsigned int newYSize) {
 		Lock();
 		ySize = newYSize;
 		Unlock();
+		Hook::BoundsChanged();
 	}
 }
 
@@ -7,12 +7,10 @@ using namespace Drawing;
 
 UITab::~UITab() {
 	ui->Lock();
-	// Remove all hooks associated to the tab.
-	for (auto it = Hooks.begin(); it != Hooks.end(); it++){
-		Hook* h = *it;
-		delete h;
+	// Remove all hooks associated to the tab, each one takes itself off the list.
+	while (Hooks.size() > 0) {
+		delete (*Hooks.begin());
 	}
-	Hooks.clear();
 	
 	// Remove tab from list.
 	ui->Tabs.remove(this);
@@ -1,9 +1,10 @@
 #include "MPQInit.h"
 #include "MPQReader.h"
+#include <atomic>
 
 unsigned int STAT_MAX;
 unsigned int SKILL_MAX;
-bool initialized = false;
+std::atomic<bool> initialized(false);
 
 std::vector<StatProperties*> AllStatList;
 std::unordered_map<std::string, StatProperties*> StatMap;
@@ -1042,33 +1043,49 @@ bool IsInitialized() {
 	return initialized;
 }
 
-// If we find the temp file with MPQ info, use it; otherwise, fall back on the hardcoded lists.
-void InitializeMPQData() {
-	if (initialized) return;
-	
+// Returns the parsed txt file, or NULL if it couldn't be read. Uses find()
+// so the loaders can share the map from several threads.
+static MPQData* GetMpqFile(const char* name) {
+	auto it = MpqDataMap.find(name);
+	return it == MpqDataMap.end() ? NULL : it->second;
+}
+
+// Returns the row's value for the column, or an empty string if the row
+// doesn't have it. The rows are shared with the table loaders running at the
+// same time, so they must not be written to (operator[] would insert).
+static const std::string& GetField(const std::map<std::string, std::string>& row, const char* name) {
+	static const std::string empty;
+	auto it = row.find(name);
+	return it == row.end() ? empty : it->second;
+}
+
+void InitializeStatData() {
+	MPQData *skills = GetMpqFile("skills"), *charstats = GetMpqFile("charstats"), *itemstatcost = GetMpqFile("itemstatcost");
+	if (!skills || !charstats || !itemstatcost) return;
+
 	char* end;
 	short lastID = -1;
 
-	for (auto d = MpqDataMap["skills"]->data.begin(); d < MpqDataMap["skills"]->data.end(); d++) {
-		if ((*d)["Id"].length() > 0) {
-			unsigned short id = (unsigned short)std::strtoul((*d)["Id"].c_str(), &end, 10);
+	for (auto d = skills->data.begin(); d < skills->data.end(); d++) {
+		if (GetField(*d, "Id").length() > 0) {
+			unsigned short id = (unsigned short)std::strtoul(GetField(*d, "Id").c_str(), &end, 10);
 			if (id > SKILL_MAX) {
 				SKILL_MAX = id;
 			}
     }
   }
 
-	for (auto d = MpqDataMap["charstats"]->data.begin(); d < MpqDataMap["charstats"]->data.end(); d++) {
-		if ((*d)["ToHitFactor"].length() > 0) {
+	for (auto d = charstats->data.begin(); d < charstats->data.end(); d++) {
+		if (GetField(*d, "ToHitFactor").length() > 0) {
 			CharStats *bits = new CharStats();
-			bits->toHitFactor = std::stoi((*d)["ToHitFactor"].c_str(), nullptr, 10);
+			bits->toHitFactor = std::stoi(GetField(*d, "ToHitFactor").c_str(), nullptr, 10);
 			CharList.push_back(bits);
 		}
 	}
 
-	for (auto d = MpqDataMap["itemstatcost"]->data.begin(); d < MpqDataMap["itemstatcost"]->data.end(); d++) {
-		if ((*d)["ID"].length() > 0) {
-			unsigned short id = (unsigned short)std::strtoul((*d)["ID"].c_str(), &end, 10);
+	for (auto d = itemstatcost->data.begin(); d < itemstatcost->data.end(); d++) {
+		if (GetField(*d, "ID").length() > 0) {
+			unsigned short id = (unsigned short)std::strtoul(GetField(*d, "ID").c_str(), &end, 10);
 			if (id > STAT_MAX) {
 				STAT_MAX = id;
 			}
@@ -1083,64 +1100,75 @@ void InitializeMPQData() {
 			}
 
 			StatProperties *bits = new StatProperties();
-			bits->name = (*d)["Stat"];
+			bits->name = GetField(*d, "Stat");
 			std::transform(bits->name.begin(), bits->name.end(), bits->name.begin(), tolower);
 			bits->ID = id;
-			bits->sendParamBits = (BYTE)std::strtoul((*d)["Send Param Bits"].c_str(), &end, 10);
-			bits->saveBits = (BYTE)std::strtoul((*d)["Save Bits"].c_str(), &end, 10);
-			bits->saveAdd = (BYTE)std::strtoul((*d)["Save Add"].c_str(), &end, 10);
-			bits->saveParamBits = (BYTE)std::strtoul((*d)["Save Param Bits"].c_str(), &end, 10);
-			bits->op = (BYTE)std::strtoul((*d)["op"].c_str(), &end, 10);
+			bits->sendParamBits = (BYTE)std::strtoul(GetField(*d, "Send Param Bits").c_str(), &end, 10);
+			bits->saveBits = (BYTE)std::strtoul(GetField(*d, "Save Bits").c_str(), &end, 10);
+			bits->saveAdd = (BYTE)std::strtoul(GetField(*d, "Save Add").c_str(), &end, 10);
+			bits->saveParamBits = (BYTE)std::strtoul(GetField(*d, "Save Param Bits").c_str(), &end, 10);
+			bits->op = (BYTE)std::strtoul(GetField(*d, "op").c_str(), &end, 10);
 			AllStatList.push_back(bits);
 			StatMap[bits->name] = bits;
 			lastID = (short)id;
 		}
 	}
+}
+
+void InitializeInventoryData() {
+	MPQData *inventory = GetMpqFile("inventory");
+	if (!inventory) return;
 
-	for (auto d = MpqDataMap["inventory"]->data.begin(); d < MpqDataMap["inventory"]->data.end(); d++) {
+	char* end;
+	for (auto d = inventory->data.begin(); d < inventory->data.end(); d++) {
 		InventoryLayout *layout = new InventoryLayout();
-		layout->SlotWidth = (BYTE)std::strtoul((*d)["gridX"].c_str(), &end, 10);
-		layout->SlotHeight = (BYTE)std::strtoul((*d)["gridY"].c_str(), &end, 10);
-		layout->Left = (unsigned short)std::strtoul((*d)["gridLeft"].c_str(), &end, 10);
-		layout->Right = (unsigned short)std::strtoul((*d)["gridRight"].c_str(), &end, 10);
-		layout->Top = (unsigned short)std::strtoul((*d)["gridTop"].c_str(), &end, 10);
-		layout->Bottom = (unsigned short)std::strtoul((*d)["gridBottom"].c_str(), &end, 10);
-		layout->SlotPixelWidth = (BYTE)std::strtoul((*d)["gridBoxWidth"].c_str(), &end, 10);
-		layout->SlotPixelHeight = (BYTE)std::strtoul((*d)["gridBoxHeight"].c_str(), &end, 10);
-		InventoryLayoutMap[(*d)["class"]] = layout;
+		layout->SlotWidth = (BYTE)std::strtoul(GetField(*d, "gridX").c_str(), &end, 10);
+		layout->SlotHeight = (BYTE)std::strtoul(GetField(*d, "gridY").c_str(), &end, 10);
+		layout->Left = (unsigned short)std::strtoul(GetField(*d, "gridLeft").c_str(), &end, 10);
+		layout->Right = (unsigned short)std::strtoul(GetField(*d, "gridRight").c_str(), &end, 10);
+		layout->Top = (unsigned short)std::strtoul(GetField(*d, "gridTop").c_str(), &end, 10);
+		layout->Bottom = (unsigned short)std::strtoul(GetField(*d, "gridBottom").c_str(), &end, 10);
+		layout->SlotPixelWidth = (BYTE)std::strtoul(GetField(*d, "gridBoxWidth").c_str(), &end, 10);
+		layout->SlotPixelHeight = (BYTE)std::strtoul(GetField(*d, "gridBoxHeight").c_str(), &end, 10);
+		InventoryLayoutMap[GetField(*d, "class")] = layout;
 	}
+}
+
+void InitializeItemData() {
+	MPQData *itemtypes = GetMpqFile("itemtypes"), *armor = GetMpqFile("armor"), *weapons = GetMpqFile("weapons"), *misc = GetMpqFile("misc");
+	if (!itemtypes || !armor || !weapons || !misc) return;
 
 	std::map<std::string, std::string> throwableMap;
 	std::map<std::string, std::string> bodyLocMap;
 	std::map<std::string, std::string> parentMap1;
 	std::map<std::string, std::string> parentMap2;
-	for (auto d = MpqDataMap["itemtypes"]->data.begin(); d < MpqDataMap["itemtypes"]->data.end(); d++) {
-		if ((*d)["Code"].length() > 0) {
-			throwableMap[(*d)["Code"]] = (*d)["Throwable"];
-			bodyLocMap[(*d)["Code"]] = (*d)["BodyLoc1"];
-			if ((*d)["Equiv1"].length() > 0) {
-				parentMap1[(*d)["Code"]] = (*d)["Equiv1"];
+	for (auto d = itemtypes->data.begin(); d < itemtypes->data.end(); d++) {
+		if (GetField(*d, "Code").length() > 0) {
+			throwableMap[GetField(*d, "Code")] = GetField(*d, "Throwable");
+			bodyLocMap[GetField(*d, "Code")] = GetField(*d, "BodyLoc1");
+			if (GetField(*d, "Equiv1").length() > 0) {
+				parentMap1[GetField(*d, "Code")] = GetField(*d, "Equiv1");
 			}
-			if ((*d)["Equiv2"].length() > 0) {
-				parentMap2[(*d)["Code"]] = (*d)["Equiv2"];
+			if (GetField(*d, "Equiv2").length() > 0) {
+				parentMap2[GetField(*d, "Code")] = GetField(*d, "Equiv2");
 			}
 		}
 	}
 
-	for (auto d = MpqDataMap["armor"]->data.begin(); d < MpqDataMap["armor"]->data.end(); d++) {
-		if ((*d)["code"].length() > 0) {
+	for (auto d = armor->data.begin(); d < armor->data.end(); d++) {
+		if (GetField(*d, "code").length() > 0) {
 			std::set<std::string> ancestorTypes;
-			char stackable = ((*d)["stackable"].length() > 0 ? (*d)["stackable"].at(0) - 48 : 0),
-				useable = ((*d)["useable"].length() > 0 ? (*d)["useable"].at(0) - 48 : 0),
-				throwable = ((*d)["throwable"].length() > 0 ? (*d)["throwable"].at(0) - 48 : 0);
+			char stackable = (GetField(*d, "stackable").length() > 0 ? GetField(*d, "stackable").at(0) - 48 : 0),
+				useable = (GetField(*d, "useable").length() > 0 ? GetField(*d, "useable").at(0) - 48 : 0),
+				throwable = (GetField(*d, "throwable").length() > 0 ? GetField(*d, "throwable").at(0) - 48 : 0);
 
 			unsigned int flags = ITEM_GROUP_ALLARMOR, flags2 = 0;
-			FindAncestorTypes((*d)["type"], ancestorTypes, parentMap1, parentMap2);
+			FindAncestorTypes(GetField(*d, "type"), ancestorTypes, parentMap1, parentMap2);
 
-			if ((*d)["code"].compare((*d)["ultracode"]) == 0) {
+			if (GetField(*d, "code").compare(GetField(*d, "ultracode")) == 0) {
 				flags |= ITEM_GROUP_ELITE;
 			}
-			else if ((*d)["code"].compare((*d)["ubercode"]) == 0) {
+			else if (GetField(*d, "code").compare(GetField(*d, "ubercode")) == 0) {
 				flags |= ITEM_GROUP_EXCEPTIONAL;
 			}
 			else {
@@ -1149,35 +1177,35 @@ void InitializeMPQData() {
 			if (ancestorTypes.find("circ") != ancestorTypes.end()) {
 				flags |= ITEM_GROUP_CIRCLET;
 			}
-			else if (bodyLocMap[(*d)["type"]].compare("head") == 0) {
+			else if (bodyLocMap[GetField(*d, "type")].compare("head") == 0) {
 				flags |= ITEM_GROUP_HELM;
 			}
-			else if (bodyLocMap[(*d)["type"]].compare("tors") == 0) {
+			else if (bodyLocMap[GetField(*d, "type")].compare("tors") == 0) {
 				flags |= ITEM_GROUP_ARMOR;
 			}
-			else if (bodyLocMap[(*d)["type"]].compare("glov") == 0) {
+			else if (bodyLocMap[GetField(*d, "type")].compare("glov") == 0) {
 				flags |= ITEM_GROUP_GLOVES;
 			}
-			else if (bodyLocMap[(*d)["type"]].compare("feet") == 0) {
+			else if (bodyLocMap[GetField(*d, "type")].compare("feet") == 0) {
 				flags |= ITEM_GROUP_BOOTS;
 			}
-			else if (bodyLocMap[(*d)["type"]].compare("belt") == 0) {
+			else if (bodyLocMap[GetField(*d, "type")].compare("belt") == 0) {
 				flags |= ITEM_GROUP_BELT;
 			}
-			else if (bodyLocMap[(*d)["type"]].compare(1, 3, "arm") == 0 && ancestorTypes.find("shld") != ancestorTypes.end()) {
+			else if (bodyLocMap[GetField(*d, "type")].compare(1, 3, "arm") == 0 && ancestorTypes.find("shld") != ancestorTypes.end()) {
 				flags |= ITEM_GROUP_SHIELD;
 			}
-			flags = AssignClassFlags((*d)["type"], ancestorTypes, flags);
+			flags = AssignClassFlags(GetField(*d, "type"), ancestorTypes, flags);
 
 			ItemAttributes *attrs = new ItemAttributes();
-			attrs->name = (*d)["name"];
-			attrs->code[0] = (*d)["code"].c_str()[0];
-			attrs->code[1] = (*d)["code"].c_str()[1];
-			attrs->code[2] = (*d)["code"].c_str()[2];
+			attrs->name = GetField(*d, "name");
+			attrs->code[0] = GetField(*d, "code").c_str()[0];
+			attrs->code[1] = GetField(*d, "code").c_str()[1];
+			attrs->code[2] = GetField(*d, "code").c_str()[2];
 			attrs->code[3] = 0;
-			attrs->category = (*d)["type"];
-			attrs->width = (*d)["invwidth"].at(0) - '0';
-			attrs->height = (*d)["invheight"].at(0) - '0';
+			attrs->category = GetField(*d, "type");
+			attrs->width = GetField(*d, "invwidth").at(0) - '0';
+			attrs->height = GetField(*d, "invheight").at(0) - '0';
 			attrs->stackable = stackable;
 			attrs->useable = useable;
 			attrs->throwable = throwable;
@@ -1185,166 +1213,168 @@ void InitializeMPQData() {
 			attrs->unusedFlags = 0;
 			attrs->flags = flags;
 			attrs->flags2 = flags2;
-			attrs->qualityLevel = stoi((*d)["level"], nullptr, 10);
-			attrs->magicLevel = atoi((*d)["magic lvl"].c_str());
-			ItemAttributeMap[(*d)["code"]] = attrs;
+			attrs->qualityLevel = stoi(GetField(*d, "level"), nullptr, 10);
+			attrs->magicLevel = atoi(GetField(*d, "magic lvl").c_str());
+			ItemAttributeMap[GetField(*d, "code")] = attrs;
 		}
+	}
 
-		for (auto d = MpqDataMap["weapons"]->data.begin(); d < MpqDataMap["weapons"]->data.end(); d++) {
-			if ((*d)["code"].length() > 0) {
-				std::set<std::string> ancestorTypes;
-				char stackable = ((*d)["stackable"].length() > 0 ? (*d)["stackable"].at(0) - 48 : 0),
-					useable = ((*d)["useable"].length() > 0 ? (*d)["useable"].at(0) - 48 : 0),
-					throwable = ((*d)["throwable"].length() > 0 ? (*d)["throwable"].at(0) - 48 : 0);
-				unsigned int flags = ITEM_GROUP_ALLWEAPON, flags2 = 0;
-				FindAncestorTypes((*d)["type"], ancestorTypes, parentMap1, parentMap2);
-
-				if ((*d)["code"].compare((*d)["ultracode"]) == 0) {
-					flags |= ITEM_GROUP_ELITE;
-				}
-				else if ((*d)["code"].compare((*d)["ubercode"]) == 0) {
-					flags |= ITEM_GROUP_EXCEPTIONAL;
-				}
-				else {
-					flags |= ITEM_GROUP_NORMAL;
-				}
-				if (ancestorTypes.find("club") != ancestorTypes.end() ||
-					ancestorTypes.find("hamm") != ancestorTypes.end() ||
-					ancestorTypes.find("mace") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_MACE;
-				}
-				else if (ancestorTypes.find("wand") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_WAND;
-				}
-				else if (ancestorTypes.find("staf") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_STAFF;
-				}
-				else if (ancestorTypes.find("bow") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_BOW;
-				}
-				else if (ancestorTypes.find("axe") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_AXE;
-				}
-				else if (ancestorTypes.find("scep") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_SCEPTER;
-				}
-				else if (ancestorTypes.find("swor") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_SWORD;
-				}
-				else if (ancestorTypes.find("knif") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_DAGGER;
-				}
-				else if (ancestorTypes.find("spea") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_SPEAR;
-				}
-				else if (ancestorTypes.find("pole") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_POLEARM;
-				}
-				else if (ancestorTypes.find("xbow") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_CROSSBOW;
-				}
-				else if (ancestorTypes.find("jave") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_JAVELIN;
-				}
-				if (ancestorTypes.find("thro") != ancestorTypes.end()) {
-					flags |= ITEM_GROUP_THROWING;
-				}
-				flags = AssignClassFlags((*d)["type"], ancestorTypes, flags);
+	for (auto d = weapons->data.begin(); d < weapons->data.end(); d++) {
+		if (GetField(*d, "code").length() > 0) {
+			std::set<std::string> ancestorTypes;
+			char stackable = (GetField(*d, "stackable").length() > 0 ? GetField(*d, "stackable").at(0) - 48 : 0),
+				useable = (GetField(*d, "useable").length() > 0 ? GetField(*d, "useable").at(0) - 48 : 0),
+				throwable = (GetField(*d, "throwable").length() > 0 ? GetField(*d, "throwable").at(0) - 48 : 0);
+			unsigned int flags = ITEM_GROUP_ALLWEAPON, flags2 = 0;
+			FindAncestorTypes(GetField(*d, "type"), ancestorTypes, parentMap1, parentMap2);
 
-				ItemAttributes *attrs = new ItemAttributes();
-				attrs->name = (*d)["name"];
-				attrs->code[0] = (*d)["code"].c_str()[0];
-				attrs->code[1] = (*d)["code"].c_str()[1];
-				attrs->code[2] = (*d)["code"].c_str()[2];
-				attrs->code[3] = 0;
-				attrs->category = (*d)["type"];
-				attrs->width = (*d)["invwidth"].at(0) - '0';
-				attrs->height = (*d)["invheight"].at(0) - '0';
-				attrs->stackable = stackable;
-				attrs->useable = useable;
-				attrs->throwable = throwable;
-				attrs->itemLevel = 0;
-				attrs->unusedFlags = 0;
-				attrs->flags = flags;
-				attrs->flags2 = flags2;
-				attrs->qualityLevel = stoi((*d)["level"], nullptr, 10);
-				attrs->magicLevel = atoi((*d)["magic lvl"].c_str());
-				ItemAttributeMap[(*d)["code"]] = attrs;
+			if (GetField(*d, "code").compare(GetField(*d, "ultracode")) == 0) {
+				flags |= ITEM_GROUP_ELITE;
 			}
-		}
+			else if (GetField(*d, "code").compare(GetField(*d, "ubercode")) == 0) {
+				flags |= ITEM_GROUP_EXCEPTIONAL;
+			}
+			else {
+				flags |= ITEM_GROUP_NORMAL;
+			}
+			if (ancestorTypes.find("club") != ancestorTypes.end() ||
+				ancestorTypes.find("hamm") != ancestorTypes.end() ||
+				ancestorTypes.find("mace") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_MACE;
+			}
+			else if (ancestorTypes.find("wand") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_WAND;
+			}
+			else if (ancestorTypes.find("staf") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_STAFF;
+			}
+			else if (ancestorTypes.find("bow") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_BOW;
+			}
+			else if (ancestorTypes.find("axe") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_AXE;
+			}
+			else if (ancestorTypes.find("scep") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_SCEPTER;
+			}
+			else if (ancestorTypes.find("swor") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_SWORD;
+			}
+			else if (ancestorTypes.find("knif") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_DAGGER;
+			}
+			else if (ancestorTypes.find("spea") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_SPEAR;
+			}
+			else if (ancestorTypes.find("pole") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_POLEARM;
+			}
+			else if (ancestorTypes.find("xbow") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_CROSSBOW;
+			}
+			else if (ancestorTypes.find("jave") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_JAVELIN;
+			}
+			if (ancestorTypes.find("thro") != ancestorTypes.end()) {
+				flags |= ITEM_GROUP_THROWING;
+			}
+			flags = AssignClassFlags(GetField(*d, "type"), ancestorTypes, flags);
 
-		for (auto d = MpqDataMap["misc"]->data.begin(); d < MpqDataMap["misc"]->data.end(); d++) {
-			if ((*d)["code"].length() > 0) {
-				std::set<std::string> ancestorTypes;
-				char stackable = ((*d)["stackable"].length() > 0 ? (*d)["stackable"].at(0) - 48 : 0),
-					useable = ((*d)["useable"].length() > 0 ? (*d)["useable"].at(0) - 48 : 0),
-					throwable = ((*d)["throwable"].length() > 0 ? (*d)["throwable"].at(0) - 48 : 0);
-				unsigned int flags = 0, flags2 = 0;
-				FindAncestorTypes((*d)["type"], ancestorTypes, parentMap1, parentMap2);
-				FindAncestorTypes((*d)["type2"], ancestorTypes, parentMap1, parentMap2);
+			ItemAttributes *attrs = new ItemAttributes();
+			attrs->name = GetField(*d, "name");
+			attrs->code[0] = GetField(*d, "code").c_str()[0];
+			attrs->code[1] = GetField(*d, "code").c_str()[1];
+			attrs->code[2] = GetField(*d, "code").c_str()[2];
+			attrs->code[3] = 0;
+			attrs->category = GetField(*d, "type");
+			attrs->width = GetField(*d, "invwidth").at(0) - '0';
+			attrs->height = GetField(*d, "invheight").at(0) - '0';
+			attrs->stackable = stackable;
+			attrs->useable = useable;
+			attrs->throwable = throwable;
+			attrs->itemLevel = 0;
+			attrs->unusedFlags = 0;
+			attrs->flags = flags;
+			attrs->flags2 = flags2;
+			attrs->qualityLevel = stoi(GetField(*d, "level"), nullptr, 10);
+			attrs->magicLevel = atoi(GetField(*d, "magic lvl").c_str());
+			ItemAttributeMap[GetField(*d, "code")] = attrs;
+		}
+	}
 
-				if (ancestorTypes.find("rune") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_RUNE;
-				}
-				if (ancestorTypes.find("gem0") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_CHIPPED;
-				}
-				else if (ancestorTypes.find("gem1") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_FLAWED;
-				}
-				else if (ancestorTypes.find("gem2") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_REGULAR;
-				}
-				else if (ancestorTypes.find("gem3") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_FLAWLESS;
-				}
-				else if (ancestorTypes.find("gem4") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_PERFECT;
-				}
-				if (ancestorTypes.find("gema") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_AMETHYST;
-				}
-				else if (ancestorTypes.find("gemd") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_DIAMOND;
-				}
-				else if (ancestorTypes.find("geme") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_EMERALD;
-				}
-				else if (ancestorTypes.find("gemr") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_RUBY;
-				}
-				else if (ancestorTypes.find("gems") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_SAPPHIRE;
-				}
-				else if (ancestorTypes.find("gemt") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_TOPAZ;
-				}
-				else if (ancestorTypes.find("gemz") != ancestorTypes.end()) {
-					flags2 |= ITEM_GROUP_SKULL;
-				}
+	for (auto d = misc->data.begin(); d < misc->data.end(); d++) {
+		if (GetField(*d, "code").length() > 0) {
+			std::set<std::string> ancestorTypes;
+			char stackable = (GetField(*d, "stackable").length() > 0 ? GetField(*d, "stackable").at(0) - 48 : 0),
+				useable = (GetField(*d, "useable").length() > 0 ? GetField(*d, "useable").at(0) - 48 : 0),
+				throwable = (GetField(*d, "throwable").length() > 0 ? GetField(*d, "throwable").at(0) - 48 : 0);
+			unsigned int flags = 0, flags2 = 0;
+			FindAncestorTypes(GetField(*d, "type"), ancestorTypes, parentMap1, parentMap2);
+			FindAncestorTypes(GetField(*d, "type2"), ancestorTypes, parentMap1, parentMap2);
 
-				ItemAttributes *attrs = new ItemAttributes();
-				attrs->name = (*d)["name"];
-				attrs->code[0] = (*d)["code"].c_str()[0];
-				attrs->code[1] = (*d)["code"].c_str()[1];
-				attrs->code[2] = (*d)["code"].c_str()[2];
-				attrs->code[3] = 0;
-				attrs->category = (*d)["type"];
-				attrs->width = (*d)["invwidth"].at(0) - '0';
-				attrs->height = (*d)["invheight"].at(0) - '0';
-				attrs->stackable = stackable;
-				attrs->useable = useable;
-				attrs->throwable = throwable;
-				attrs->itemLevel = 0;
-				attrs->unusedFlags = 0;
-				attrs->flags = flags;
-				attrs->flags2 = flags2;
-				attrs->qualityLevel = stoi((*d)["level"], nullptr, 10);
-				attrs->magicLevel = 0;
-				ItemAttributeMap[(*d)["code"]] = attrs;
+			if (ancestorTypes.find("rune") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_RUNE;
+			}
+			if (ancestorTypes.find("gem0") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_CHIPPED;
+			}
+			else if (ancestorTypes.find("gem1") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_FLAWED;
+			}
+			else if (ancestorTypes.find("gem2") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_REGULAR;
+			}
+			else if (ancestorTypes.find("gem3") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_FLAWLESS;
+			}
+			else if (ancestorTypes.find("gem4") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_PERFECT;
+			}
+			if (ancestorTypes.find("gema") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_AMETHYST;
 			}
+			else if (ancestorTypes.find("gemd") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_DIAMOND;
+			}
+			else if (ancestorTypes.find("geme") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_EMERALD;
+			}
+			else if (ancestorTypes.find("gemr") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_RUBY;
+			}
+			else if (ancestorTypes.find("gems") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_SAPPHIRE;
+			}
+			else if (ancestorTypes.find("gemt") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_TOPAZ;
+			}
+			else if (ancestorTypes.find("gemz") != ancestorTypes.end()) {
+				flags2 |= ITEM_GROUP_SKULL;
+			}
+
+			ItemAttributes *attrs = new ItemAttributes();
+			attrs->name = GetField(*d, "name");
+			attrs->code[0] = GetField(*d, "code").c_str()[0];
+			attrs->code[1] = GetField(*d, "code").c_str()[1];
+			attrs->code[2] = GetField(*d, "code").c_str()[2];
+			attrs->code[3] = 0;
+			attrs->category = GetField(*d, "type");
+			attrs->width = GetField(*d, "invwidth").at(0) - '0';
+			attrs->height = GetField(*d, "invheight").at(0) - '0';
+			attrs->stackable = stackable;
+			attrs->useable = useable;
+			attrs->throwable = throwable;
+			attrs->itemLevel = 0;
+			attrs->unusedFlags = 0;
+			attrs->flags = flags;
+			attrs->flags2 = flags2;
+			attrs->qualityLevel = stoi(GetField(*d, "level"), nullptr, 10);
+			attrs->magicLevel = 0;
+			ItemAttributeMap[GetField(*d, "code")] = attrs;
 		}
 	}
+}
 
+void FinishMPQData() {
 	initialized = true;
 }
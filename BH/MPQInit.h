@@ -62,4 +62,12 @@ extern std::map<std::string, InventoryLayout*> InventoryLayoutMap;
 #define STAT_NUMBER(name) (StatMap[name]->ID)
 
 bool IsInitialized();
-void InitializeMPQData();
+
+// Independent steps that turn the MPQ files into the stat, inventory and
+// item data, so startup can run them in parallel once ReadMPQFiles is done.
+// IsInitialized() only turns true when FinishMPQData is called after all
+// three.
+void InitializeStatData();
+void InitializeInventoryData();
+void InitializeItemData();
+void FinishMPQData();
@@ -1,2 +1,3 @@
 #include "CollisionMap.h"
-#include "TeleportPath.h"
\ No newline at end of file
+#include "TeleportPath.h"
+#include "WalkPath.h"
\ No newline at end of file
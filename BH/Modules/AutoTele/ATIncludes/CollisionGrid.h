@@ -0,0 +1,376 @@
+//////////////////////////////////////////////////////////////////////
+// CollisionGrid.h
+//
+// Collision map storage. CCollisionGrid holds the raw collision values
+// row by row in a single block, CPathGrid is the packed, read-only copy
+// the teleport path finder works on.
+//
+// This header, MapDump.h and the path finders only need the few Windows
+// types defined below elsewhere, so Tools/MapBench can build them on any
+// platform.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __COLLISIONGRID_H__
+#define __COLLISIONGRID_H__
+
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stdlib.h>
+#include <string.h>
+typedef int BOOL;
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef const char* LPCSTR;
+typedef struct tagPOINT { LONG x; LONG y; } POINT, *LPPOINT;
+typedef struct tagRECT { LONG left; LONG top; LONG right; LONG bottom; } RECT;
+#define TRUE 1
+#define FALSE 0
+using std::min;
+using std::max;
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+class CCollisionGrid
+{
+public:
+
+	CCollisionGrid() : m_cx(0), m_cy(0) {}
+
+	BOOL Create(int cx, int cy, uint16_t initValue)
+	{
+		Destroy();
+		if (cx <= 0 || cy <= 0)
+			return FALSE;
+
+		m_cx = cx;
+		m_cy = cy;
+		m_aData.assign((size_t)cx * cy, initValue);
+		return TRUE;
+	}
+
+	void Destroy()
+	{
+		std::vector<uint16_t>().swap(m_aData);
+		m_cx = 0;
+		m_cy = 0;
+	}
+
+	BOOL IsCreated() const { return !m_aData.empty(); }
+	BOOL IsValidIndex(int x, int y) const { return x >= 0 && x < m_cx && y >= 0 && y < m_cy; }
+	int GetCX() const { return m_cx; }
+	int GetCY() const { return m_cy; }
+
+	uint16_t& operator()(int x, int y) { return m_aData[y * m_cx + x]; }
+	const uint16_t& operator()(int x, int y) const { return m_aData[y * m_cx + x]; }
+	uint16_t* GetRow(int y) { return &m_aData[y * m_cx]; }
+	const uint16_t* GetRow(int y) const { return &m_aData[y * m_cx]; }
+
+private:
+
+	std::vector<uint16_t> m_aData; // Row major, m_cx cells per row
+	int m_cx;
+	int m_cy;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Row kernels
+//
+// The whole-map passes work on rows packed to one bit per cell, bit x
+// of word x / 32 for cell x, so neighbour tests become shifts and masks
+// over 32 cells at a time. Only the packing looks at every cell, it uses
+// SSE2 when the compiler targets it and plain C otherwise. Both produce
+// the same bits, Tools/MapBench checks that they do.
+//////////////////////////////////////////////////////////////////////
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define COLLISION_GRID_SSE2
+#include <emmintrin.h>
+#endif
+
+inline int GetRowWords(int cx)
+{
+	return (cx + 31) >> 5;
+}
+
+// Plain C version of PackBlockedCells, packs the cells from x on, x a
+// multiple of 32
+inline void PackBlockedCellsScalar(const uint16_t* pRow, int cx, uint32_t* pBits, int x = 0)
+{
+	for (; x < GetRowWords(cx) << 5; x++)
+	{
+		if ((x & 31) == 0)
+			pBits[x >> 5] = 0;
+		if (x >= cx || (pRow[x] % 2))
+			pBits[x >> 5] |= 1u << (x & 31);
+	}
+}
+
+// Plain C version of PackEqualCells, packs the cells from x on, x a
+// multiple of 32
+inline void PackEqualCellsScalar(const uint16_t* pRow, int cx, uint16_t wValue, uint32_t* pBits, int x = 0)
+{
+	for (; x < GetRowWords(cx) << 5; x++)
+	{
+		if ((x & 31) == 0)
+			pBits[x >> 5] = 0;
+		if (x < cx && pRow[x] == wValue)
+			pBits[x >> 5] |= 1u << (x & 31);
+	}
+}
+
+// Sets the bit of every blocked (odd) cell. Bits past cx are set as well,
+// outside the map counts as blocked.
+inline void PackBlockedCells(const uint16_t* pRow, int cx, uint32_t* pBits)
+{
+	int x = 0;
+#ifdef COLLISION_GRID_SSE2
+	for (; x + 32 <= cx; x += 32)
+	{
+		// Move bit 0 of each cell to its sign bit, then pack the signs into a mask
+		__m128i a = _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(pRow + x)), 15);
+		__m128i b = _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(pRow + x + 8)), 15);
+		__m128i c = _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(pRow + x + 16)), 15);
+		__m128i d = _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(pRow + x + 24)), 15);
+		pBits[x >> 5] = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(a, b)) |
+			((uint32_t)_mm_movemask_epi8(_mm_packs_epi16(c, d)) << 16);
+	}
+#endif
+	PackBlockedCellsScalar(pRow, cx, pBits, x);
+}
+
+// Sets the bit of every cell holding wValue, bits past cx are cleared
+inline void PackEqualCells(const uint16_t* pRow, int cx, uint16_t wValue, uint32_t* pBits)
+{
+	int x = 0;
+#ifdef COLLISION_GRID_SSE2
+	__m128i value = _mm_set1_epi16((short)wValue);
+	for (; x + 32 <= cx; x += 32)
+	{
+		__m128i a = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(pRow + x)), value);
+		__m128i b = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(pRow + x + 8)), value);
+		__m128i c = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(pRow + x + 16)), value);
+		__m128i d = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(pRow + x + 24)), value);
+		pBits[x >> 5] = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(a, b)) |
+			((uint32_t)_mm_movemask_epi8(_mm_packs_epi16(c, d)) << 16);
+	}
+#endif
+	PackEqualCellsScalar(pRow, cx, wValue, pBits, x);
+}
+
+// Index of the lowest set bit, dwBits must not be 0
+inline int GetLowestCell(uint32_t dwBits)
+{
+#ifdef _MSC_VER
+	unsigned long nBit;
+	_BitScanForward(&nBit, dwBits);
+	return (int)nBit;
+#else
+	return __builtin_ctz(dwBits);
+#endif
+}
+
+// Writes wValue to the cells of word i whose bit is set
+inline void SetCells(uint16_t* pRow, int i, uint32_t dwBits, uint16_t wValue)
+{
+	while (dwBits)
+	{
+		pRow[(i << 5) + GetLowestCell(dwBits)] = wValue;
+		dwBits &= dwBits - 1;
+	}
+}
+
+// Word i of the row moved so that bit k holds cell 32 * i + k + n,
+// -31 <= n <= 31. Cells outside the row read as dwFill.
+inline uint32_t ShiftCells(const uint32_t* pBits, int nWords, int i, int n, uint32_t dwFill)
+{
+	if (n > 0)
+		return (pBits[i] >> n) | ((i + 1 < nWords ? pBits[i + 1] : dwFill) << (32 - n));
+	if (n < 0)
+		return (pBits[i] << -n) | ((i > 0 ? pBits[i - 1] : dwFill) >> (32 + n));
+	return pBits[i];
+}
+
+// Fills every gap inside left <= x < right, top <= y < bottom with wFill:
+// an open cell that isn't part of 3 open cells in a row both across and
+// down within 2 cells of it. Outside the map counts as blocked, filled
+// cells count as blocked as soon as they're filled.
+//
+// The result is the same as testing one cell at a time column by column,
+// which MapBench checks. When a cell is judged, only the 2 cells before
+// it across and above it can have been filled. Those are final whether
+// the pass goes by columns or by rows, so going by rows gives the same
+// result, and the whole test down a column is masks over rows that don't
+// change any more. Across, a cell whose next 2 cells are open is never a
+// gap, so only the few others are visited one by one.
+inline void FillGapCells(CCollisionGrid& grid, int left, int top, int right, int bottom, uint16_t wFill)
+{
+	const int CX = grid.GetCX();
+	const int CY = grid.GetCY();
+	left = max(left, 0);
+	top = max(top, 0);
+	right = min(right, CX);
+	bottom = min(bottom, CY);
+	if (left >= right || top >= bottom)
+		return;
+
+	// Packed blocked bits of the rows the pass reads, 2 above and below,
+	// updated as cells are filled
+	const int nWords = GetRowWords(CX);
+	const int nFirst = max(top - 2, 0);
+	const int nLast = min(bottom + 2, CY);
+	std::vector<uint32_t> aBlocked((nLast - nFirst) * nWords);
+	for (int y = nFirst; y < nLast; y++)
+		PackBlockedCells(grid.GetRow(y), CX, &aBlocked[(y - nFirst) * nWords]);
+
+	for (int y = top; y < bottom; y++)
+	{
+		const uint32_t* pRows[5]; // y - 2 to y + 2, NULL outside the map
+		for (int n = 0; n < 5; n++)
+			pRows[n] = (y + n - 2 >= 0 && y + n - 2 < CY) ? &aBlocked[(y + n - 2 - nFirst) * nWords] : NULL;
+		uint32_t* pBits = &aBlocked[(y - nFirst) * nWords];
+		uint16_t* pRow = grid.GetRow(y);
+
+		for (int i = left >> 5; i <= (right - 1) >> 5; i++)
+		{
+			uint32_t dwOpen = ~pBits[i];
+			uint32_t dwUp2 = pRows[0] ? ~pRows[0][i] : 0;
+			uint32_t dwUp1 = pRows[1] ? ~pRows[1][i] : 0;
+			uint32_t dwDown1 = pRows[3] ? ~pRows[3][i] : 0;
+			uint32_t dwDown2 = pRows[4] ? ~pRows[4][i] : 0;
+			uint32_t dwDown = (dwUp2 & dwUp1 & dwOpen) | (dwUp1 & dwOpen & dwDown1) | (dwOpen & dwDown1 & dwDown2);
+			uint32_t dwNext = ~ShiftCells(pBits, nWords, i, 1, 0xFFFFFFFF) & ~ShiftCells(pBits, nWords, i, 2, 0xFFFFFFFF);
+
+			// Gaps down the column, and the cells that depend on the ones before them
+			uint32_t dwVisit = dwOpen & (~dwDown | ~dwNext);
+			if (i == left >> 5)
+				dwVisit &= 0xFFFFFFFF << (left & 31);
+			if (i == (right - 1) >> 5)
+				dwVisit &= 0xFFFFFFFF >> (31 - ((right - 1) & 31));
+
+			while (dwVisit)
+			{
+				int nBit = GetLowestCell(dwVisit);
+				dwVisit &= dwVisit - 1;
+				int x = (i << 5) + nBit;
+
+				BOOL bGap = !((dwDown >> nBit) & 1);
+				if (!bGap)
+				{
+					// 5 cells across, x - 2 first, set if open
+					uint32_t dwAcross = 0;
+					for (int n = 0; n < 5; n++)
+					{
+						int nCell = x + n - 2;
+						if (nCell >= 0 && nCell < CX && !((pBits[nCell >> 5] >> (nCell & 31)) & 1))
+							dwAcross |= 1u << n;
+					}
+					bGap = !(dwAcross & (dwAcross >> 1) & (dwAcross >> 2));
+				}
+
+				if (bGap)
+				{
+					pBits[i] |= 1u << nBit;
+					pRow[x] = wFill;
+				}
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// One bit per cell, set when the cell is blocked (odd collision value,
+// which includes invalid, filled and avoided cells). Never modified
+// after construction, so it can be shared between threads through a
+// std::shared_ptr<const CPathGrid> without locking.
+//
+// The bits are stored in PATH_TILE sized tiles. Maps spanning several
+// levels are mostly empty space between the levels, so tiles without a
+// single walkable cell aren't stored at all.
+//////////////////////////////////////////////////////////////////////
+#define PATH_TILE_SHIFT		5
+#define PATH_TILE			(1 << PATH_TILE_SHIFT)	// 32 cells, one word per tile row
+#define PATH_TILE_BLOCKED	-1						// Directory entry of a tile with no walkable cell
+
+class CPathGrid
+{
+public:
+
+	explicit CPathGrid(const CCollisionGrid& grid) : m_cx(grid.GetCX()), m_cy(grid.GetCY())
+	{
+		m_nTilesX = (m_cx + PATH_TILE - 1) >> PATH_TILE_SHIFT;
+		m_nTilesY = (m_cy + PATH_TILE - 1) >> PATH_TILE_SHIFT;
+		m_aTiles.assign(m_nTilesX * m_nTilesY, PATH_TILE_BLOCKED);
+
+		// One tile high band of packed rows, a tile row is one word of it
+		std::vector<uint32_t> aBand(PATH_TILE * m_nTilesX);
+		uint32_t aTile[PATH_TILE];
+		for (int ty = 0; ty < m_nTilesY; ty++)
+		{
+			int nTop = ty << PATH_TILE_SHIFT;
+			for (int y = 0; y < PATH_TILE; y++)
+			{
+				if (nTop + y < m_cy)
+					PackBlockedCells(grid.GetRow(nTop + y), m_cx, &aBand[y * m_nTilesX]);
+				else
+					std::fill(aBand.begin() + y * m_nTilesX, aBand.begin() + (y + 1) * m_nTilesX, 0xFFFFFFFF);
+			}
+
+			for (int tx = 0; tx < m_nTilesX; tx++)
+			{
+				BOOL bOpen = FALSE;
+				for (int y = 0; y < PATH_TILE; y++)
+				{
+					aTile[y] = aBand[y * m_nTilesX + tx];
+					bOpen |= aTile[y] != 0xFFFFFFFF;
+				}
+
+				if (bOpen)
+				{
+					m_aTiles[ty * m_nTilesX + tx] = (int)(m_aBits.size() >> PATH_TILE_SHIFT);
+					m_aBits.insert(m_aBits.end(), aTile, aTile + PATH_TILE);
+				}
+			}
+		}
+	}
+
+	int GetCX() const { return m_cx; }
+	int GetCY() const { return m_cy; }
+	BOOL IsValidIndex(int x, int y) const { return x >= 0 && x < m_cx && y >= 0 && y < m_cy; }
+
+	BOOL IsOpen(int x, int y) const
+	{
+		int nTile = m_aTiles[(y >> PATH_TILE_SHIFT) * m_nTilesX + (x >> PATH_TILE_SHIFT)];
+		if (nTile == PATH_TILE_BLOCKED)
+			return FALSE;
+		return !((m_aBits[(nTile << PATH_TILE_SHIFT) + (y & (PATH_TILE - 1))] >> (x & (PATH_TILE - 1))) & 1);
+	}
+
+	// FALSE if the tile holding the cell has no walkable cell at all
+	BOOL IsTileOpen(int x, int y) const
+	{
+		return m_aTiles[(y >> PATH_TILE_SHIFT) * m_nTilesX + (x >> PATH_TILE_SHIFT)] != PATH_TILE_BLOCKED;
+	}
+
+private:
+
+	std::vector<int> m_aTiles;	// Tile directory, index into m_aBits in tiles or PATH_TILE_BLOCKED
+	std::vector<uint32_t> m_aBits;	// PATH_TILE rows per stored tile
+	int m_nTilesX;
+	int m_nTilesY;
+	int m_cx;
+	int m_cy;
+};
+
+typedef std::shared_ptr<const CPathGrid> PathGridPtr;
+
+#endif // __COLLISIONGRID_H__
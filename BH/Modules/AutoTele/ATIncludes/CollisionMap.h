@@ -5,9 +5,14 @@
 //////////////////////////////////////////////////////////////////////
 
 #include <windows.h>
+#include <bitset>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "ArrayEx.h"
-#include "Matrix.h"
+#include "CollisionGrid.h"
+#include "MapDump.h"
+#include "RoomGraph.h"
 #include "../../../D2Ptrs.h"
 
 #ifndef __COLLISIONMAP_H__
@@ -22,9 +27,11 @@
 #define EXIT_LEVEL                      1
 #define EXIT_TILE                       2
 
+#define MAP_MAX_AREAS           4     // Most areas a single map can span
+#define MAP_CACHE_SIZE          4     // Maps kept by CCollisionMapCache
+
 typedef CArrayEx<DWORD, DWORD> DwordArray;
 typedef CArrayEx<WORD, WORD> WordArray;
-typedef CMatrix<WORD, WORD> WordMatrix;
 
 typedef struct LevelExit_t
 {
@@ -53,8 +60,11 @@ public:
         ////////////////////////////////////////////////////////////
         BOOL CreateMap(DWORD AreaId); // Create the map data
         BOOL CreateMap(DWORD AreaId[], int nSize);//Allow for multiple area ids
+        BOOL UpdateMap(); // Add the rooms that appeared since the map was created
+        BOOL IsMapOf(const DWORD AreaId[], int nSize) const; // Created from exactly these areas
         void DestroyMap();
         BOOL DumpMap(LPCSTR lpszFilePath, const LPPOINT lpPath, DWORD dwCount) const; // Dump map data into a disk file
+        BOOL CopyMapDump(CMapDump& rDump); // Compact copy with the areas and their exits, loadable without the game
 
         ////////////////////////////////////////////////////////////
         // Attributes & Operations
@@ -63,8 +73,10 @@ public:
         SIZE GetMapSize() const; // map size
         WORD GetMapData(long x, long y, BOOL bAbs) const; // Retrieve map data at a particular location
         BOOL IsValidAbsLocation(long x, long y) const; // Map location verification
-        SIZE CopyMapData(WORD** ppBuffer, int cx, int cy) const;
-        BOOL CopyMapData(WordMatrix& rBuffer) const;
+        BOOL CopyMapData(CCollisionGrid& rBuffer) const;
+        PathGridPtr GetPathGrid() const; // Read-only packed copy for path finding, shared until the map changes
+        RoomGraphPtr GetRoomGraph() const; // Rooms in the map and which of them touch, shared until rooms are added
+        DWORD GetRevision() const { return m_dwRevision; } // Changes whenever UpdateMap adds rooms
         BOOL ReportCollisionType(POINT ptOrigin, long lRadius) const;
         int CCollisionMap::GetLevelExits(LPLevelExit* lpLevel);
 
@@ -73,9 +85,8 @@ public:
         ////////////////////////////////////////////////////////////
         void AbsToRelative(POINT& pt) const; // Convert an absolute map location into a graph index
         void RelativeToAbs(POINT& pt) const; // Convert a graph index into an absolute map location
-        static void MakeBlank(WordMatrix& rMatrix, POINT pos);
-        static BOOL ThickenWalls(WordMatrix& rMatrix, int nThickenBy = 1);
-        BOOL IsGap(int x, int y);
+        static void MakeBlank(CCollisionGrid& rGrid, POINT pos);
+        static BOOL ThickenWalls(CCollisionGrid& rGrid, int nThickenBy = 1);
         BOOL CheckCollision(int x, int y);
 
         ////////////////////////////////////////////////////////////
@@ -91,11 +102,14 @@ private:
         // Private Methods
         ////////////////////////////////////////////////////////////
         BOOL BuildMapData(DWORD AreaIds[], int nSize);
-        void Search(Room2* ro, UnitAny* pPlayer, DwordArray& aSkip, DWORD dwScanArea);
+        void SearchAreas(UnitAny* pPlayer);
+        void AddRoom(Room2* ro, UnitAny* pPlayer);
         void AddCollisionData(const CollMap* pCol);     
         char IsMarkPoint(const POINT& ptPlayer, int x, int y, const LPPOINT lpPath, DWORD dwCount) const;
+        DWORD CountRooms() const;
 
         void FillGaps();
+        void FillGaps(const RECT& rcArea);
 
         ////////////////////////////////////////////////////////////
         // Member Data
@@ -103,11 +117,39 @@ private:
         
         BYTE m_iCurMap; // Current map ID
         POINT m_ptLevelOrigin; // level top-left
-        WordArray m_aCollisionTypes;
-        WordMatrix m_map; // The map
+        std::bitset<0x10000> m_collisionTypes; // Every collision value seen
+        CCollisionGrid m_map; // The map
+        mutable PathGridPtr m_pPathGrid; // Snapshot of m_map, reset whenever m_map changes
+        mutable RoomGraphPtr m_pRoomGraph; // Graph of m_rooms, reset whenever rooms are added
+        DWORD m_aAreas[MAP_MAX_AREAS]; // Areas the map was created from
+        int m_nAreas;
+        DWORD m_dwRoomCount; // Rooms in those areas when last searched
+        DWORD m_dwRevision;
+        std::unordered_set<Room2*> m_rooms; // Rooms whose collision data is already in the map
+        RECT m_rcAdded; // Map cells written by the last search
         
 };
 
+////////////////////////////////////////////////////////////////
+// Keeps the last few collision maps around so teleporting again
+// in the same area doesn't rebuild the map from every room. The
+// maps are dropped when the act or the game changes.
+////////////////////////////////////////////////////////////////
+class CCollisionMapCache
+{
+public:
+        CCollisionMapCache();
+        virtual ~CCollisionMapCache();
+
+        CCollisionMap* GetMap(DWORD AreaId[], int nSize); // Cached map of the areas, NULL if it can't be built
+        void Clear();
+
+private:
+        CCollisionMap* m_aMaps[MAP_CACHE_SIZE]; // Most recently used first
+        DWORD m_dwMapSeed;
+        DWORD m_dwAct;
+};
+
 #endif // __COLLISIONMAP_H__
 
 // CollisionMap.cpp: implementation of the CCollisionMap class.
@@ -132,7 +174,11 @@ DWORD GetTileLevelNo(Room2* lpRoom2, DWORD dwTileNo)
 CCollisionMap::CCollisionMap()
 {
 	m_iCurMap = 0x00;
+	m_nAreas = 0;
+	m_dwRoomCount = 0;
+	m_dwRevision = 0;
 	::memset(&m_ptLevelOrigin, 0, sizeof(POINT));
+	::SetRectEmpty(&m_rcAdded);
 }
 
 CCollisionMap::~CCollisionMap()
@@ -144,11 +190,12 @@ void CCollisionMap::OnMapChanged(BYTE iNewMapID)
 	if (iNewMapID != m_iCurMap)
 	{
 		m_iCurMap = iNewMapID;
-		//m_map.Lock();
 		m_map.Destroy();
-		//m_map.Unlock();
+		m_pPathGrid.reset();
+		m_pRoomGraph.reset();
+		m_rooms.clear();
 		::memset(&m_ptLevelOrigin, 0, sizeof(POINT));
-		m_aCollisionTypes.RemoveAll();
+		m_collisionTypes.reset();
 	}
 }
 
@@ -167,27 +214,25 @@ void CCollisionMap::AddCollisionData(const CollMap* pCol)
 		return;
 	}	
 	
-	int nLimitX = x + cx;
-	int nLimitY = y + cy;
+	int nLimitX = min(x + cx, m_map.GetCX());
+	int nLimitY = min(y + cy, m_map.GetCY());
 	
-	WORD* p = pCol->pMapStart;
-	for (int j = y; j < nLimitY; j++)		
+	const WORD* p = pCol->pMapStart;
+	for (int j = y; j < nLimitY; j++, p += cx)
 	{
+		WORD* pRow = m_map.GetRow(j);
+		::memcpy(pRow + x, p, (nLimitX - x) * sizeof(WORD));
+
 		for (int i = x; i < nLimitX; i++)
 		{
-			m_map[i][j] = *p;
-			if (m_map[i][j] == 1024)
-				m_map[i][j] = MAP_DATA_AVOID;
-
-			if (m_aCollisionTypes.Find(*p) == -1)
-			{
-				m_aCollisionTypes.Add(*p);
-				m_aCollisionTypes.Sort();
-			}
-
-			p++;
+			m_collisionTypes.set(pRow[i]);
+			if (pRow[i] == 1024)
+				pRow[i] = MAP_DATA_AVOID;
 		}
 	}
+
+	RECT rcRoom = { x, y, nLimitX, nLimitY };
+	::UnionRect(&m_rcAdded, &m_rcAdded, &rcRoom);
 }
 
 BOOL CCollisionMap::IsValidAbsLocation(long x, long y) const
@@ -216,7 +261,7 @@ WORD CCollisionMap::GetMapData(long x, long y, BOOL bAbs) const
 	WORD wVal = (WORD)MAP_DATA_INVALID;
 
 	if (m_map.IsValidIndex(x, y))
-		wVal = m_map[x][y];
+		wVal = m_map(x, y);
 
 	//m_map.Unlock();
 	return wVal;
@@ -233,16 +278,17 @@ BOOL CCollisionMap::BuildMapData(DWORD AreaIds[], int nSize)
 		return FALSE;
 
 
-	//Get the most left-top level for the base and the size of the entire wanted map
+	//Get the bounding box of all the wanted levels, its top-left is the map origin
 	Level* pBestLevel = AutoTele::GetLevel(D2CLIENT_GetPlayerUnit()->pAct, AreaIds[0]);
-	DWORD dwXSize = 0;
-	DWORD dwYSize = 0;
-	m_ptLevelOrigin.x = pBestLevel->dwPosX * 5;
-	m_ptLevelOrigin.y = pBestLevel->dwPosY * 5;
+	if (!pBestLevel)
+		return FALSE;
+
+	RECT rcBounds = { (LONG)pBestLevel->dwPosX * 5, (LONG)pBestLevel->dwPosY * 5,
+		(LONG)(pBestLevel->dwPosX + pBestLevel->dwSizeX) * 5, (LONG)(pBestLevel->dwPosY + pBestLevel->dwSizeY) * 5 };
 	dwLevelId = AreaIds[0];
 
 	//Loop all the given areas
-	for (int n = 0; n < nSize; n++) {
+	for (int n = 1; n < nSize; n++) {
 		//Get the level struct for given id
 		Level* pLevel = AutoTele::GetLevel(D2CLIENT_GetPlayerUnit()->pAct, AreaIds[n]);
 	
@@ -250,39 +296,94 @@ BOOL CCollisionMap::BuildMapData(DWORD AreaIds[], int nSize)
 		if (!pLevel)
 			continue;
 
-		//Check if this level is even more top-left then the current one
-		if((m_ptLevelOrigin.x / 5) > (int)pLevel->dwPosX)
-			m_ptLevelOrigin.x = pLevel->dwPosX * 5;
-
-		if((m_ptLevelOrigin.y / 5) > (int)pLevel->dwPosY)
-			m_ptLevelOrigin.y = pLevel->dwPosY * 5;
-
-		//Add the size of the levels.
-		dwXSize += pLevel->dwSizeX * 5;
-		dwYSize += pLevel->dwSizeY * 5;
+		RECT rcLevel = { (LONG)pLevel->dwPosX * 5, (LONG)pLevel->dwPosY * 5,
+			(LONG)(pLevel->dwPosX + pLevel->dwSizeX) * 5, (LONG)(pLevel->dwPosY + pLevel->dwSizeY) * 5 };
+		::UnionRect(&rcBounds, &rcBounds, &rcLevel);
 	}
 
-	if (!m_map.Create(dwXSize, dwYSize, (WORD)MAP_DATA_INVALID))
+	m_ptLevelOrigin.x = rcBounds.left;
+	m_ptLevelOrigin.y = rcBounds.top;
+	if (!m_map.Create(rcBounds.right - rcBounds.left, rcBounds.bottom - rcBounds.top, (WORD)MAP_DATA_INVALID))
 		return FALSE;
 
-	DwordArray aSkip;
-	for (int n = 0; n < nSize; n++) {
-		Level* pLevel = AutoTele::GetLevel(D2CLIENT_GetPlayerUnit()->pAct, AreaIds[n]);
+	m_nAreas = min(nSize, MAP_MAX_AREAS);
+	::memcpy(m_aAreas, AreaIds, m_nAreas * sizeof(DWORD));
+	m_dwRoomCount = CountRooms();
+	SearchAreas(pUnit);
+		
+	FillGaps();
+	FillGaps();
+
+	return TRUE;
+}
+
+void CCollisionMap::SearchAreas(UnitAny* pPlayer)
+{
+	::SetRectEmpty(&m_rcAdded);
+	for (int n = 0; n < m_nAreas; n++) {
+		Level* pLevel = AutoTele::GetLevel(pPlayer->pAct, m_aAreas[n]);
 		if (!pLevel)
 			continue;
 
-		Search(pLevel->pRoom2First, pUnit, aSkip, AreaIds[n]);
+		// Every room of the level is in this list, rooms already in the
+		// map are skipped
+		for (Room2* ro = pLevel->pRoom2First; ro; ro = ro->pRoom2Next)
+			AddRoom(ro, pPlayer);
+	}
+}
+
+DWORD CCollisionMap::CountRooms() const
+{
+	DWORD dwCount = 0;
+	for (int n = 0; n < m_nAreas; n++) {
+		Level* pLevel = AutoTele::GetLevel(D2CLIENT_GetPlayerUnit()->pAct, m_aAreas[n]);
+		if (!pLevel)
+			continue;
+
+		for (Room2* ro = pLevel->pRoom2First; ro; ro = ro->pRoom2Next)
+			dwCount++;
+	}
+	return dwCount;
+}
+
+BOOL CCollisionMap::UpdateMap()
+{
+	UnitAny* pUnit = D2CLIENT_GetPlayerUnit();
+	if (!m_map.IsCreated() || !pUnit)
+		return FALSE;
+
+	DWORD dwRooms = CountRooms();
+	if (dwRooms == m_dwRoomCount)
+		return TRUE;
+
+	m_dwRoomCount = dwRooms;
+	m_dwRevision++;
+	m_pPathGrid.reset();
+	m_pRoomGraph.reset();
+	SearchAreas(pUnit);
+
+	// Gaps are found from the 2 cells around each cell, twice over
+	if (!::IsRectEmpty(&m_rcAdded))
+	{
+		::InflateRect(&m_rcAdded, 4, 4);
+		FillGaps(m_rcAdded);
+		FillGaps(m_rcAdded);
 	}
-		
-	FillGaps();
-	FillGaps();
 
 	return TRUE;
 }
 
-void CCollisionMap::Search(Room2 *ro, UnitAny* pPlayer, DwordArray &aSkip, DWORD dwScanArea)
+BOOL CCollisionMap::IsMapOf(const DWORD AreaId[], int nSize) const
+{
+	if (!m_map.IsCreated() || nSize != m_nAreas)
+		return FALSE;
+
+	return ::memcmp(m_aAreas, AreaId, nSize * sizeof(DWORD)) == 0;
+}
+
+void CCollisionMap::AddRoom(Room2 *ro, UnitAny* pPlayer)
 {
-	if (!ro || ro->pLevel->dwLevelNo != dwScanArea || aSkip.Find((DWORD)ro) != -1 || pPlayer == NULL)
+	if (!m_rooms.insert(ro).second)
 		return;
 
 	BOOL add_room=FALSE;
@@ -292,20 +393,11 @@ void CCollisionMap::Search(Room2 *ro, UnitAny* pPlayer, DwordArray &aSkip, DWORD
 		D2COMMON_AddRoomData(pPlayer->pAct, ro->pLevel->dwLevelNo, ro->dwPosX, ro->dwPosY, pPlayer->pPath->pRoom1);
 	}
 
-	aSkip.Add((DWORD)ro);
-	aSkip.Sort();
-
 	if (ro->pRoom1)
 	{
 		AddCollisionData(ro->pRoom1->Coll);
 	}
 	
-	Room2 **n = ro->pRoom2Near;
-	for(UINT i=0; i < ro->dwRoomsNear; i++)
-	{
-		Search(n[i], pPlayer, aSkip, dwScanArea);
-	}
-	
 	if(add_room)
 	{
 		D2COMMON_RemoveRoomData(pPlayer->pAct,ro->pLevel->dwLevelNo, ro->dwPosX, ro->dwPosY, pPlayer->pPath->pRoom1);
@@ -358,9 +450,10 @@ BOOL CCollisionMap::DumpMap(LPCSTR lpszFilePath, const LPPOINT lpPath, DWORD dwC
 	char szMapName[256] = "";
 
 	fprintf(fp, "%s (Size: %d * %d)\nKnown Collision Types: ", szMapName, m_map.GetCX(), m_map.GetCY());
-	for (int i = 0; i < m_aCollisionTypes.GetSize(); i++)
+	for (int i = 0; i < (int)m_collisionTypes.size(); i++)
 	{
-		fprintf(fp, "%d, ", m_aCollisionTypes[i]);
+		if (m_collisionTypes.test(i))
+			fprintf(fp, "%d, ", i);
 	}
 
 	fprintf(fp, "\n\n");
@@ -388,7 +481,7 @@ BOOL CCollisionMap::DumpMap(LPCSTR lpszFilePath, const LPPOINT lpPath, DWORD dwC
 			char ch = IsMarkPoint(ptPlayer, x, y, pPath, dwCount);			
 
 			if (!ch)
-				ch = (m_map[x][y] % 2) ? 'X' : ' ';
+				ch = (m_map(x, y) % 2) ? 'X' : ' ';
 
 			fprintf(fp, "%C", ch); // X - unreachable
 		}
@@ -410,7 +503,7 @@ BOOL CCollisionMap::CheckCollision(int x, int y) {
 	if(x > m_map.GetCX() || y > m_map.GetCY())
 		return FALSE;
 	BOOL Works = FALSE;
-	Works = (m_map[x][y] % 2) ? FALSE : TRUE;
+	Works = (m_map(x, y) % 2) ? FALSE : TRUE;
 return Works;
 }
 
@@ -450,111 +543,77 @@ SIZE CCollisionMap::GetMapSize() const
 	return cz;
 }
 
-SIZE CCollisionMap::CopyMapData(WORD** ppBuffer, int cx, int cy) const
+void CCollisionMap::FillGaps()
 {
-	SIZE copied = {0};
-	//m_map.Lock();
-	copied = m_map.ExportData(ppBuffer, cx, cy);
-	//m_map.Unlock();
-	return copied;
+	RECT rcMap = { 0, 0, m_map.GetCX(), m_map.GetCY() };
+	FillGaps(rcMap);
 }
 
-BOOL CCollisionMap::IsGap(int x, int y) 
-{
-	if (m_map[x][y] % 2)
-		return FALSE;
-
-	int nSpaces = 0;
-	int i = 0;
-
-	// Horizontal check
-	for (i = x - 2; i <= x + 2 && nSpaces < 3; i++)
-	{
-		if ( i < 0 || i >= m_map.GetCX() || (m_map[i][y] % 2))
-			nSpaces = 0;
-		else
-			nSpaces++;
-	}
-
-	if (nSpaces < 3)
-		return TRUE;
-
-	// Vertical check
-	nSpaces = 0;
-	for (i = y - 2; i <= y + 2 && nSpaces < 3; i++)
-	{
-		if ( i < 0 || i >= m_map.GetCY() || (m_map[x][i] % 2))
-			nSpaces = 0;
-		else
-			nSpaces++;
-	}
-
-	return nSpaces < 3;
-}
-
-void CCollisionMap::FillGaps()
+void CCollisionMap::FillGaps(const RECT& rcArea)
 {
 	if (!m_map.IsCreated())
 		return;
 
-	//m_map.Lock();
-
-	const int CX = m_map.GetCX();
-	const int CY = m_map.GetCY();
-
-	for (int x = 0; x <CX; x++)
-	{
-		for (int y = 0; y < CY; y++)
-		{
-			if (IsGap(x, y))
-				m_map[x][y] = MAP_DATA_FILLED;
-		}
-	}
-
-	//m_map.Unlock();
+	FillGapCells(m_map, rcArea.left, rcArea.top, rcArea.right, rcArea.bottom, MAP_DATA_FILLED);
 }
 
-void CCollisionMap::MakeBlank(WordMatrix& rMatrix, POINT pos)
+void CCollisionMap::MakeBlank(CCollisionGrid& rGrid, POINT pos)
 {
-	if (!rMatrix.IsCreated())
+	if (!rGrid.IsCreated())
 		return;
 
 	for (int i = pos.x - 1; i <= pos.x + 1; i++)
 	{
 		for (int j = pos.y - 1; j <= pos.y + 1; j++)
 		{
-			if (rMatrix.IsValidIndex(i, j))
-				rMatrix[i][j] = MAP_DATA_CLEANED;
+			if (rGrid.IsValidIndex(i, j))
+				rGrid(i, j) = MAP_DATA_CLEANED;
 		}
 	}
 }
 
-BOOL CCollisionMap::ThickenWalls(WordMatrix& rMatrix, int nThickenBy)
+BOOL CCollisionMap::ThickenWalls(CCollisionGrid& rGrid, int nThickenBy)
 {
-	if (!rMatrix.IsCreated() || nThickenBy <= 0)
+	if (!rGrid.IsCreated() || nThickenBy <= 0)
 		return FALSE;
 
-	const int CX = rMatrix.GetCX();
-	const int CY = rMatrix.GetCY();
-	
-	for (int i = 0; i < CX; i++)
+	const int CX = rGrid.GetCX();
+	const int CY = rGrid.GetCY();
+	const int nWords = GetRowWords(CX);
+
+	// Walls (blocked cells that weren't thickened themselves) grown across
+	// by nThickenBy cells, one cell per step
+	std::vector<uint32_t> aBlocked(CY * nWords), aWalls(CY * nWords), aTemp(nWords);
+	for (int y = 0; y < CY; y++)
 	{
-		for (int j = 0; j < CY; j++)
+		uint32_t* pBlocked = &aBlocked[y * nWords];
+		uint32_t* pWalls = &aWalls[y * nWords];
+		PackBlockedCells(rGrid.GetRow(y), CX, pBlocked);
+		PackEqualCells(rGrid.GetRow(y), CX, MAP_DATA_THICKENED, pWalls);
+		for (int i = 0; i < nWords; i++)
+			pWalls[i] = pBlocked[i] & ~pWalls[i];
+		if (CX & 31)
+			pWalls[nWords - 1] &= 0xFFFFFFFF >> (32 - (CX & 31));
+
+		for (int n = 0; n < nThickenBy; n++)
 		{
-			if ((rMatrix[i][j] % 2) == 0 || rMatrix[i][j] == MAP_DATA_THICKENED)
-				continue;
+			for (int i = 0; i < nWords; i++)
+				aTemp[i] = pWalls[i] | ShiftCells(pWalls, nWords, i, -1, 0) | ShiftCells(pWalls, nWords, i, 1, 0);
+			std::copy(aTemp.begin(), aTemp.end(), pWalls);
+		}
+	}
 
-			for (int x = i - nThickenBy; x <= i + nThickenBy; x++)
-			{
-				for (int y = j - nThickenBy; y <= j + nThickenBy; y++)
-				{
-					if (!rMatrix.IsValidIndex(x, y))
-						continue;
+	// then down, and every open cell they cover is thickened
+	for (int y = 0; y < CY; y++)
+	{
+		uint16_t* pRow = rGrid.GetRow(y);
+		for (int i = 0; i < nWords; i++)
+		{
+			uint32_t dwCovered = 0;
+			for (int j = max(y - nThickenBy, 0); j <= min(y + nThickenBy, CY - 1); j++)
+				dwCovered |= aWalls[j * nWords + i];
 
-					if ((rMatrix[x][y] % 2) == 0)
-						rMatrix[x][y] = MAP_DATA_THICKENED;
-				}
-			}
+			SetCells(pRow, i, dwCovered & ~aBlocked[y * nWords + i], MAP_DATA_THICKENED);
 		}
 	}
 
@@ -563,22 +622,85 @@ BOOL CCollisionMap::ThickenWalls(WordMatrix& rMatrix, int nThickenBy)
 
 void CCollisionMap::DestroyMap()
 {
-	//m_map.Lock();
 	m_map.Destroy();
-	//m_map.Unlock();
+	m_pPathGrid.reset();
+	m_pRoomGraph.reset();
 	m_iCurMap = 0x00;
-	m_aCollisionTypes.RemoveAll();
+	m_collisionTypes.reset();
+	m_rooms.clear();
+	m_nAreas = 0;
+	m_dwRoomCount = 0;
 	::memset(&m_ptLevelOrigin, 0, sizeof(POINT));
 }
 
-BOOL CCollisionMap::CopyMapData(WordMatrix& rBuffer) const
+BOOL CCollisionMap::CopyMapData(CCollisionGrid& rBuffer) const
 {
-	//m_map.Lock();
-	m_map.ExportData(rBuffer);
-	//m_map.Unlock();
+	rBuffer = m_map;
 	return rBuffer.IsCreated();
 }
 
+BOOL CCollisionMap::CopyMapDump(CMapDump& rDump)
+{
+	rDump.Clear();
+	if (!CopyMapData(rDump.grid))
+		return FALSE;
+
+	rDump.ptOrigin = m_ptLevelOrigin;
+	rDump.aLevels.assign(m_aAreas, m_aAreas + m_nAreas);
+
+	LPLevelExit aExits[0x40];
+	int nExits = GetLevelExits(aExits);
+	for (int i = 0; i < nExits; i++)
+	{
+		MapDumpExit exit = { aExits[i]->ptPos, aExits[i]->dwTargetLevel, aExits[i]->dwType };
+		rDump.aExits.push_back(exit);
+		delete aExits[i];
+	}
+	return TRUE;
+}
+
+PathGridPtr CCollisionMap::GetPathGrid() const
+{
+	if (!m_map.IsCreated())
+		return PathGridPtr();
+
+	if (!m_pPathGrid)
+		m_pPathGrid = std::make_shared<CPathGrid>(m_map);
+	return m_pPathGrid;
+}
+
+RoomGraphPtr CCollisionMap::GetRoomGraph() const
+{
+	if (!m_map.IsCreated())
+		return RoomGraphPtr();
+
+	if (!m_pRoomGraph)
+	{
+		std::shared_ptr<CRoomGraph> pGraph = std::make_shared<CRoomGraph>();
+		std::unordered_map<Room2*, int> aIndex;
+		for (auto it = m_rooms.begin(); it != m_rooms.end(); it++)
+		{
+			Room2* ro = *it;
+			RECT rcCells = { (LONG)ro->dwPosX * 5 - m_ptLevelOrigin.x, (LONG)ro->dwPosY * 5 - m_ptLevelOrigin.y,
+				(LONG)(ro->dwPosX + ro->dwSizeX) * 5 - m_ptLevelOrigin.x, (LONG)(ro->dwPosY + ro->dwSizeY) * 5 - m_ptLevelOrigin.y };
+			aIndex[ro] = pGraph->AddRoom(rcCells);
+		}
+
+		// Only rooms in the map, which takes in the exits between its levels
+		for (auto it = aIndex.begin(); it != aIndex.end(); it++)
+		{
+			for (DWORD i = 0; i < it->first->dwRoomsNear; i++)
+			{
+				auto pNear = aIndex.find(it->first->pRoom2Near[i]);
+				if (pNear != aIndex.end() && pNear->second != it->second)
+					pGraph->Link(it->second, pNear->second);
+			}
+		}
+		m_pRoomGraph = pGraph;
+	}
+	return m_pRoomGraph;
+}
+
 BOOL CCollisionMap::ReportCollisionType(POINT ptOrigin, long lRadius) const
 {
 	if (!m_map.IsCreated() || lRadius < 1)
@@ -594,8 +716,8 @@ BOOL CCollisionMap::ReportCollisionType(POINT ptOrigin, long lRadius) const
 			if (!m_map.IsValidIndex(i, j))
 				continue;
 
-			if (aList.Find(m_map[i][j]) == -1)
-				aList.Add(m_map[i][j]);
+			if (aList.Find(m_map(i, j)) == -1)
+				aList.Add(m_map(i, j));
 		}
 	}
 
@@ -626,14 +748,14 @@ int CCollisionMap::GetLevelExits(LPLevelExit* lpLevel)
 
 	for(int i = 0; i < m_map.GetCX(); i++)
 	{
-		if(!(m_map[i][0] % 2))
+		if(!(m_map(i, 0) % 2))
 		{
 			ptExitPoints[nTotalPoints][0].x = i;
 			ptExitPoints[nTotalPoints][0].y = 0;
 
 			for(i++; i < m_map.GetCX(); i++)
 			{
-				if(m_map[i][0] % 2)
+				if(m_map(i, 0) % 2)
 				{
 					ptExitPoints[nTotalPoints][1].x = i - 1;
 					ptExitPoints[nTotalPoints][1].y = 0;
@@ -648,14 +770,14 @@ int CCollisionMap::GetLevelExits(LPLevelExit* lpLevel)
 
 	for(int i = 0; i < m_map.GetCX(); i++)
 	{
-		if(!(m_map[i][m_map.GetCY() - 1] % 2))
+		if(!(m_map(i, m_map.GetCY() - 1) % 2))
 		{
 			ptExitPoints[nTotalPoints][0].x = i;
 			ptExitPoints[nTotalPoints][0].y = m_map.GetCY() - 1;
 
 			for(i++; i < m_map.GetCX(); i++)
 			{
-				if((m_map[i][m_map.GetCY() - 1] % 2))
+				if((m_map(i, m_map.GetCY() - 1) % 2))
 				{
 					ptExitPoints[nTotalPoints][1].x = i - 1;
 					ptExitPoints[nTotalPoints][1].y = m_map.GetCY() - 1;
@@ -670,14 +792,14 @@ int CCollisionMap::GetLevelExits(LPLevelExit* lpLevel)
 
 	for(int i = 0; i < m_map.GetCY(); i++)
 	{
-		if(!(m_map[0][i] % 2))
+		if(!(m_map(0, i) % 2))
 		{
 			ptExitPoints[nTotalPoints][0].x = 0;
 			ptExitPoints[nTotalPoints][0].y = i;
 
 			for(i++; i < m_map.GetCY(); i++)
 			{
-				if((m_map[0][i] % 2))
+				if((m_map(0, i) % 2))
 				{
 					ptExitPoints[nTotalPoints][1].x = 0;
 					ptExitPoints[nTotalPoints][1].y = i - 1;
@@ -692,14 +814,14 @@ int CCollisionMap::GetLevelExits(LPLevelExit* lpLevel)
 
 	for(int i = 0; i < m_map.GetCY(); i++)
 	{
-		if(!(m_map[m_map.GetCX() - 1][i] % 2))
+		if(!(m_map(m_map.GetCX() - 1, i) % 2))
 		{
 			ptExitPoints[nTotalPoints][0].x = m_map.GetCX() - 1;
 			ptExitPoints[nTotalPoints][0].y = i;
 
 			for(i++; i < m_map.GetCY(); i++)
 			{
-				if((m_map[m_map.GetCX() - 1][i] % 2))
+				if((m_map(m_map.GetCX() - 1, i) % 2))
 				{
 					ptExitPoints[nTotalPoints][1].x = m_map.GetCX() - 1;
 					ptExitPoints[nTotalPoints][1].y = i - 1;
@@ -837,4 +959,78 @@ int CCollisionMap::GetLevelExits(LPLevelExit* lpLevel)
 	//LeaveCriticalSection(&CriticalSection);
 	delete [] ptCenters;
 	return nCurrentExit;
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////
+// CCollisionMapCache
+//////////////////////////////////////////////////////////////////////
+
+CCollisionMapCache::CCollisionMapCache()
+{
+	::memset(m_aMaps, 0, sizeof(m_aMaps));
+	m_dwMapSeed = 0;
+	m_dwAct = 0;
+}
+
+CCollisionMapCache::~CCollisionMapCache()
+{
+	Clear();
+}
+
+void CCollisionMapCache::Clear()
+{
+	for (int i = 0; i < MAP_CACHE_SIZE; i++)
+	{
+		delete m_aMaps[i];
+		m_aMaps[i] = NULL;
+	}
+}
+
+CCollisionMap* CCollisionMapCache::GetMap(DWORD AreaId[], int nSize)
+{
+	UnitAny* pPlayer = D2CLIENT_GetPlayerUnit();
+	if (!pPlayer || !pPlayer->pAct || nSize <= 0 || nSize > MAP_MAX_AREAS)
+		return NULL;
+
+	// Room pointers from another act are no longer valid
+	if (pPlayer->pAct->dwMapSeed != m_dwMapSeed || pPlayer->pAct->dwAct != m_dwAct)
+	{
+		Clear();
+		m_dwMapSeed = pPlayer->pAct->dwMapSeed;
+		m_dwAct = pPlayer->pAct->dwAct;
+	}
+
+	CCollisionMap* pMap = NULL;
+	int nSlot = MAP_CACHE_SIZE - 1;
+	for (int i = 0; i < MAP_CACHE_SIZE; i++)
+	{
+		if (m_aMaps[i] && m_aMaps[i]->IsMapOf(AreaId, nSize))
+		{
+			pMap = m_aMaps[i];
+			nSlot = i;
+			break;
+		}
+	}
+
+	if (pMap == NULL)
+	{
+		pMap = new CCollisionMap;
+		if (!pMap->CreateMap(AreaId, nSize))
+		{
+			delete pMap;
+			return NULL;
+		}
+		delete m_aMaps[nSlot]; // least recently used
+	}
+	else if (!pMap->UpdateMap())
+	{
+		delete pMap;
+		m_aMaps[nSlot] = NULL;
+		return NULL;
+	}
+
+	for (int i = nSlot; i > 0; i--)
+		m_aMaps[i] = m_aMaps[i - 1];
+	m_aMaps[0] = pMap;
+	return pMap;
+}
@@ -0,0 +1,199 @@
+//////////////////////////////////////////////////////////////////////
+// MapDump.h
+//
+// Compact on-disk copy of a collision map: where it sits, which areas
+// it was built from, their exits and which cells are blocked. Only the
+// blocked bit of each cell is kept, that's all the path finders look
+// at. Needs nothing from the game, so dumps taken in game can be loaded
+// by tools built against this header and CollisionGrid.h alone.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __MAPDUMP_H__
+#define __MAPDUMP_H__
+
+#include <fstream>
+#include <vector>
+#include "CollisionGrid.h"
+
+// Layout (little endian):
+//   header: uint32 magic, uint32 version, int32 origin x, int32 origin y, uint32 cx, uint32 cy
+//   areas:  uint32 count, count * uint32 level id
+//   exits:  uint32 count, count * (int32 x, int32 y, uint32 target level, uint32 type)
+//   rows:   cy rows of uint16 run lengths summing to cx, alternating open and
+//           blocked cells and starting with open (a row may start with 0)
+#define MAP_DUMP_MAGIC          0x4D434842	// "BHCM"
+#define MAP_DUMP_VERSION        1
+#define MAP_DUMP_MAX_SIZE       0x4000		// Larger than any level, guards against bad files
+#define MAP_DUMP_OPEN           0			// Cell values of a loaded grid
+#define MAP_DUMP_BLOCKED        1
+
+struct MapDumpExit
+{
+	POINT ptPos; // Absolute
+	DWORD dwTargetLevel;
+	DWORD dwType;
+};
+
+class CMapDump
+{
+public:
+
+	CMapDump() { ptOrigin.x = 0; ptOrigin.y = 0; }
+
+	BOOL Save(LPCSTR lpszFilePath) const
+	{
+		if (lpszFilePath == NULL || !grid.IsCreated())
+			return FALSE;
+
+		std::ofstream file(lpszFilePath, std::ofstream::binary | std::ofstream::trunc);
+		if (!file.is_open())
+			return FALSE;
+
+		Write<uint32_t>(file, MAP_DUMP_MAGIC);
+		Write<uint32_t>(file, MAP_DUMP_VERSION);
+		Write<int32_t>(file, (int32_t)ptOrigin.x);
+		Write<int32_t>(file, (int32_t)ptOrigin.y);
+		Write<uint32_t>(file, (uint32_t)grid.GetCX());
+		Write<uint32_t>(file, (uint32_t)grid.GetCY());
+
+		Write<uint32_t>(file, (uint32_t)aLevels.size());
+		for (size_t i = 0; i < aLevels.size(); i++)
+			Write<uint32_t>(file, aLevels[i]);
+
+		Write<uint32_t>(file, (uint32_t)aExits.size());
+		for (size_t i = 0; i < aExits.size(); i++)
+		{
+			Write<int32_t>(file, (int32_t)aExits[i].ptPos.x);
+			Write<int32_t>(file, (int32_t)aExits[i].ptPos.y);
+			Write<uint32_t>(file, aExits[i].dwTargetLevel);
+			Write<uint32_t>(file, aExits[i].dwType);
+		}
+
+		std::vector<uint16_t> aRuns;
+		for (int y = 0; y < grid.GetCY(); y++)
+		{
+			const uint16_t* pRow = grid.GetRow(y);
+			bool bBlocked = false;
+			uint16_t wRun = 0;
+			aRuns.clear();
+			for (int x = 0; x < grid.GetCX(); x++)
+			{
+				if (((pRow[x] % 2) != 0) != bBlocked)
+				{
+					aRuns.push_back(wRun);
+					bBlocked = !bBlocked;
+					wRun = 0;
+				}
+				wRun++;
+			}
+			aRuns.push_back(wRun);
+			file.write((const char*)&aRuns[0], aRuns.size() * sizeof(uint16_t));
+		}
+		return file.good();
+	}
+
+	// On failure the dump is left empty
+	BOOL Load(LPCSTR lpszFilePath)
+	{
+		Clear();
+		if (lpszFilePath == NULL)
+			return FALSE;
+
+		std::ifstream file(lpszFilePath, std::ifstream::binary);
+		if (!file.is_open())
+			return FALSE;
+
+		uint32_t dwMagic = 0, dwVersion = 0, cx = 0, cy = 0, dwCount = 0;
+		if (!Read(file, dwMagic) || !Read(file, dwVersion) || dwMagic != MAP_DUMP_MAGIC || dwVersion != MAP_DUMP_VERSION ||
+			!Read(file, ptOrigin.x) || !Read(file, ptOrigin.y) || !Read(file, cx) || !Read(file, cy) ||
+			cx > MAP_DUMP_MAX_SIZE || cy > MAP_DUMP_MAX_SIZE || !Read(file, dwCount) || dwCount > 0x100)
+		{
+			Clear();
+			return FALSE;
+		}
+
+		aLevels.resize(dwCount);
+		for (uint32_t i = 0; i < dwCount; i++)
+		{
+			if (!Read(file, aLevels[i]))
+			{
+				Clear();
+				return FALSE;
+			}
+		}
+
+		if (!Read(file, dwCount) || dwCount > 0x100)
+		{
+			Clear();
+			return FALSE;
+		}
+
+		aExits.resize(dwCount);
+		for (uint32_t i = 0; i < dwCount; i++)
+		{
+			if (!Read(file, aExits[i].ptPos.x) || !Read(file, aExits[i].ptPos.y) ||
+				!Read(file, aExits[i].dwTargetLevel) || !Read(file, aExits[i].dwType))
+			{
+				Clear();
+				return FALSE;
+			}
+		}
+
+		if (!grid.Create((int)cx, (int)cy, MAP_DUMP_OPEN))
+		{
+			Clear();
+			return FALSE;
+		}
+
+		for (int y = 0; y < (int)cy; y++)
+		{
+			uint16_t* pRow = grid.GetRow(y);
+			uint16_t wValue = MAP_DUMP_OPEN;
+			int x = 0;
+			do
+			{
+				uint16_t wRun = 0;
+				if (!Read(file, wRun) || wRun > (int)cx - x)
+				{
+					Clear();
+					return FALSE;
+				}
+				std::fill(pRow + x, pRow + x + wRun, wValue);
+				x += wRun;
+				wValue = wValue == MAP_DUMP_OPEN ? MAP_DUMP_BLOCKED : MAP_DUMP_OPEN;
+			} while (x < (int)cx);
+		}
+		return TRUE;
+	}
+
+	void Clear()
+	{
+		ptOrigin.x = 0;
+		ptOrigin.y = 0;
+		aLevels.clear();
+		aExits.clear();
+		grid.Destroy();
+	}
+
+	POINT ptOrigin; // Absolute position of cell (0, 0)
+	std::vector<DWORD> aLevels;
+	std::vector<MapDumpExit> aExits;
+	CCollisionGrid grid;
+
+private:
+
+	template <typename T>
+	static void Write(std::ofstream& file, T value)
+	{
+		file.write((const char*)&value, sizeof(T));
+	}
+
+	template <typename T>
+	static bool Read(std::ifstream& file, T& value)
+	{
+		file.read((char*)&value, sizeof(T));
+		return file.good();
+	}
+};
+
+#endif // __MAPDUMP_H__
@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////
+// RoomGraph.h
+//
+// The rooms of a collision map and which rooms touch, used to narrow
+// down the cells the teleport path finder has to look at. Rooms of
+// different levels touch where the levels join, so a map spanning
+// several levels is one graph.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __ROOMGRAPH_H__
+#define __ROOMGRAPH_H__
+
+#include <windows.h>
+#include <limits.h>
+#include <math.h>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+class CRoomGraph
+{
+public:
+
+	int AddRoom(const RECT& rcCells)
+	{
+		Room room;
+		room.rcCells = rcCells;
+		m_aRooms.push_back(room);
+		return (int)m_aRooms.size() - 1;
+	}
+
+	void Link(int nRoom, int nNear)
+	{
+		m_aRooms[nRoom].aNear.push_back(nNear);
+	}
+
+	int GetSize() const { return (int)m_aRooms.size(); }
+
+	// Room holding the map cell, -1 if none does
+	int FindRoom(POINT pt) const
+	{
+		for (int i = 0; i < (int)m_aRooms.size(); i++)
+		{
+			if (::PtInRect(&m_aRooms[i].rcCells, pt))
+				return i;
+		}
+		return -1;
+	}
+
+	//////////////////////////////////////////////////////////////////
+	// Shortest chain of touching rooms from ptStart to ptEnd, measured
+	// between room centers. The rooms on it plus every room touching
+	// them go into aRects, the margin lets teleports cut corners and
+	// jump walls. FALSE if either point is outside the rooms or no chain
+	// exists.
+	//////////////////////////////////////////////////////////////////
+	BOOL FindCorridor(POINT ptStart, POINT ptEnd, std::vector<RECT>& aRects) const
+	{
+		int nStart = FindRoom(ptStart);
+		int nEnd = FindRoom(ptEnd);
+		if (nStart < 0 || nEnd < 0)
+			return FALSE;
+
+		typedef std::pair<int, int> Entry; // distance, room
+		std::vector<int> aDistance(m_aRooms.size(), INT_MAX);
+		std::vector<int> aParent(m_aRooms.size(), -1);
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+		aDistance[nStart] = 0;
+		open.push(Entry(0, nStart));
+		while (!open.empty())
+		{
+			Entry top = open.top();
+			open.pop();
+			if (top.second == nEnd)
+				break;
+			if (top.first > aDistance[top.second])
+				continue; // already reached a shorter way
+
+			const Room& room = m_aRooms[top.second];
+			for (size_t i = 0; i < room.aNear.size(); i++)
+			{
+				int nNear = room.aNear[i];
+				int nDistance = top.first + GetCenterDistance(room, m_aRooms[nNear]);
+				if (nDistance < aDistance[nNear])
+				{
+					aDistance[nNear] = nDistance;
+					aParent[nNear] = top.second;
+					open.push(Entry(nDistance, nNear));
+				}
+			}
+		}
+
+		if (aDistance[nEnd] == INT_MAX)
+			return FALSE;
+
+		std::vector<bool> aUsed(m_aRooms.size(), false);
+		for (int nRoom = nEnd; nRoom >= 0; nRoom = aParent[nRoom])
+		{
+			aUsed[nRoom] = true;
+			const Room& room = m_aRooms[nRoom];
+			for (size_t i = 0; i < room.aNear.size(); i++)
+				aUsed[room.aNear[i]] = true;
+		}
+
+		aRects.clear();
+		for (size_t i = 0; i < m_aRooms.size(); i++)
+		{
+			if (aUsed[i])
+				aRects.push_back(m_aRooms[i].rcCells);
+		}
+		return TRUE;
+	}
+
+private:
+
+	struct Room
+	{
+		RECT rcCells;				// Map cells covered, relative to the map origin
+		std::vector<int> aNear;		// Rooms touching this one
+	};
+
+	static int GetCenterDistance(const Room& a, const Room& b)
+	{
+		double dx = ((a.rcCells.left + a.rcCells.right) - (b.rcCells.left + b.rcCells.right)) / 2.0;
+		double dy = ((a.rcCells.top + a.rcCells.bottom) - (b.rcCells.top + b.rcCells.bottom)) / 2.0;
+		return (int)sqrt(dx * dx + dy * dy);
+	}
+
+	std::vector<Room> m_aRooms;
+};
+
+typedef std::shared_ptr<const CRoomGraph> RoomGraphPtr;
+
+#endif // __ROOMGRAPH_H__
@@ -15,33 +15,78 @@
 #ifndef __TELEPORTPATH_H__
 #define __TELEPORTPATH_H__
 
-#include <windows.h>
 #include <math.h>
+#include <queue>
+#include <vector>
+#include "CollisionGrid.h"
 //#include <stdio.h>
 
 class CTeleportPath  
 {
 public:	
 	
-	CTeleportPath(WORD** pCollisionMap, int cx, int cy);
+	CTeleportPath(const CPathGrid& grid);
 	virtual ~CTeleportPath();	
 
 	DWORD FindTeleportPath(POINT ptStart, POINT ptEnd, LPPOINT lpBuffer, DWORD dwMaxCount); // Calculate path
 
+	void RestrictTo(const std::vector<RECT>& aAreas); // Only land inside these areas, none means anywhere
+	BOOL MakeField(POINT ptEnd); // Hops to ptEnd from every landing cell
+	DWORD FollowField(POINT ptStart, LPPOINT lpBuffer, DWORD dwMaxCount) const; // Path to the field's end, no search needed
+
 private:
 
-	//BOOL DumpDistanceTable(LPCSTR lpszFilePath) const;	
-	static int GetRedundancy(const LPPOINT lpPath, DWORD dwMaxCount, const POINT& pos);
-	void Block(POINT pos, int nRange);
-	BOOL GetBestMove(POINT& rResult, int nAdjust = 2);
-	BOOL MakeDistanceTable();
+	struct OpenNode
+	{
+		int nCost;		// Hops so far plus the estimate to the destination
+		int nDistance;	// Squared distance to the destination, breaks ties
+		int nBlock;
+		bool operator>(const OpenNode& other) const
+		{
+			return nCost != other.nCost ? nCost > other.nCost : nDistance > other.nDistance;
+		}
+	};
+
+	void MakeNodes();
+	template <class Visit> void VisitNeighbours(POINT pos, Visit visit) const;
+	int GetEstimate(int x, int y) const;
 	BOOL IsValidIndex(int x, int y) const;
+	static BOOL InRange(int x1, int y1, int x2, int y2);
+	static int GetDistance2(int x1, int y1, int x2, int y2);
 
-	WORD** m_ppTable;	// Distance table
+	const CPathGrid& m_grid;
 	POINT m_ptStart;
 	POINT m_ptEnd;
 	int m_nCX;
 	int m_nCY;
+	int m_nBlocksX;
+	int m_nBlocksY;
+	std::vector<POINT> m_aNodes;	// Landing cell of each block, x = -1 if the block is all walls
+	std::vector<int> m_aField;		// Teleports from each landing cell to m_ptEnd, RANGE_INVALID if unreachable
+	std::vector<RECT> m_aAreas;		// Blocks outside these get no landing cell, unless empty
+};
+
+////////////////////////////////////////////////////////////////
+// A hop field towards one destination, in absolute map
+// coordinates. Holds on to the map snapshot it was made from, so
+// it can be built on a worker thread and kept around for the whole
+// trip. Const once made, any thread may call FindPath.
+////////////////////////////////////////////////////////////////
+class CTeleportField
+{
+public:
+
+	CTeleportField(PathGridPtr pGrid, POINT ptOrigin, POINT ptEnd);
+
+	DWORD FindPath(POINT ptStart, LPPOINT lpBuffer, DWORD dwMaxCount) const;
+	POINT GetEnd() const { return m_ptEnd; }
+
+private:
+
+	PathGridPtr m_pGrid; // Declared before m_path, which refers to it
+	CTeleportPath m_path;
+	POINT m_ptOrigin;
+	POINT m_ptEnd;
 };
 
 #endif // __TELEPORTPATH_H__
@@ -54,6 +99,7 @@ private:
 
 #define TP_RANGE		35		// Maximum teleport range
 #define RANGE_INVALID	10000  // invalid range flag
+#define TP_BLOCK		4		// Size of the blocks the map is split into, one landing cell each
 
 /////////////////////////////////////////////////////////////////////
 // Path Finding Result
@@ -67,11 +113,12 @@ enum {   PATH_FAIL = 0,     // Failed, error occurred or no available path
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
 
-CTeleportPath::CTeleportPath(WORD** pCollisionMap, int cx, int cy)
+CTeleportPath::CTeleportPath(const CPathGrid& grid) : m_grid(grid)
 {
-	m_ppTable = pCollisionMap;
-	m_nCX = cx;
-	m_nCY = cy;
+	m_nCX = grid.GetCX();
+	m_nCY = grid.GetCY();
+	m_nBlocksX = 0;
+	m_nBlocksY = 0;
 	::memset(&m_ptStart, 0, sizeof(POINT));
 	::memset(&m_ptEnd, 0, sizeof(POINT));
 }
@@ -80,154 +127,253 @@ CTeleportPath::~CTeleportPath()
 {
 }
 
-BOOL CTeleportPath::MakeDistanceTable()
-{	
-	if (m_ppTable == NULL)
-		return FALSE;
+/////////////////////////////////////////////////////////////////////
+// Teleport graph
+//
+// Teleporting can land on any walkable cell within TP_RANGE, walls in
+// between don't matter. Searching every cell would be far too slow, so
+// the map is split into TP_BLOCK sized blocks and each block with a
+// walkable cell gets one landing cell, the one closest to its center.
+// Narrow corridors still get nodes since any walkable cell qualifies.
+/////////////////////////////////////////////////////////////////////
+void CTeleportPath::MakeNodes()
+{
+	m_nBlocksX = (m_nCX + TP_BLOCK - 1) / TP_BLOCK;
+	m_nBlocksY = (m_nCY + TP_BLOCK - 1) / TP_BLOCK;
+
+	POINT none = { -1, -1 };
+	m_aNodes.assign(m_nBlocksX * m_nBlocksY, none);
 
-	// convert the graph into a distance table
-	for (int x = 0; x < m_nCX; x++)	
+	std::vector<bool> aAllowed;
+	if (!m_aAreas.empty())
 	{
-		for (int y = 0; y < m_nCY; y++)
+		aAllowed.assign(m_nBlocksX * m_nBlocksY, false);
+		for (size_t i = 0; i < m_aAreas.size(); i++)
 		{
-			if ((m_ppTable[x][y] % 2) == 0)
-				m_ppTable[x][y] = (short)AutoTele::GetDistanceSquared(x, y, m_ptEnd.x, m_ptEnd.y);
-			else
-				m_ppTable[x][y] = RANGE_INVALID;
+			const RECT& rc = m_aAreas[i];
+			for (int bx = max(0, (int)rc.left / TP_BLOCK); bx <= min(m_nBlocksX - 1, (int)(rc.right - 1) / TP_BLOCK); bx++)
+			{
+				for (int by = max(0, (int)rc.top / TP_BLOCK); by <= min(m_nBlocksY - 1, (int)(rc.bottom - 1) / TP_BLOCK); by++)
+					aAllowed[by * m_nBlocksX + bx] = true;
+			}
 		}
 	}
 
-	m_ppTable[m_ptEnd.x][m_ptEnd.y] = 1;	
-	return TRUE;
-}
-
-/////////////////////////////////////////////////////////////////////
-// The "Get Best Move" Algorithm
-//
-// Originally developed by Niren7, Modified by Abin
-/////////////////////////////////////////////////////////////////////
-BOOL CTeleportPath::GetBestMove(POINT& pos, int nAdjust)
-{	
-	if(AutoTele::GetDistanceSquared(m_ptEnd.x, m_ptEnd.y, pos.x, pos.y) <= TP_RANGE)
+	for (int bx = 0; bx < m_nBlocksX; bx++)
 	{
-		pos = m_ptEnd;
-		return PATH_REACHED; // we reached the destination
-	}
-
-	if (!IsValidIndex(pos.x, pos.y))
-		return PATH_FAIL; // fail
+		for (int by = 0; by < m_nBlocksY; by++)
+		{
+			if (!m_grid.IsTileOpen(bx * TP_BLOCK, by * TP_BLOCK))
+				continue; // blocks never straddle tiles
 
-	Block(pos, nAdjust);
+			if (!aAllowed.empty() && !aAllowed[by * m_nBlocksX + bx])
+				continue;
 
-	POINT p, best;
-	int value = RANGE_INVALID;
+			int cx = bx * TP_BLOCK + TP_BLOCK / 2;
+			int cy = by * TP_BLOCK + TP_BLOCK / 2;
+			int nBest = RANGE_INVALID;
+			POINT& node = m_aNodes[by * m_nBlocksX + bx];
 
-	for (p.x = pos.x - TP_RANGE; p.x <= pos.x + TP_RANGE; p.x++)
-	{
-		for (p.y = pos.y - TP_RANGE; p.y <= pos.y + TP_RANGE; p.y++)
-		{			
-			if (!IsValidIndex(p.x, p.y))
-				continue;
-		
-			if (m_ppTable[p.x][p.y] < value && AutoTele::GetDistanceSquared(p.x, p.y, pos.x, pos.y) <= TP_RANGE)
-			{				
-				value = m_ppTable[p.x][p.y];
-				best = p;					
-			}			
+			for (int x = bx * TP_BLOCK; x < (bx + 1) * TP_BLOCK && x < m_nCX; x++)
+			{
+				for (int y = by * TP_BLOCK; y < (by + 1) * TP_BLOCK && y < m_nCY; y++)
+				{
+					int nDistance = GetDistance2(x, y, cx, cy);
+					if (nDistance < nBest && m_grid.IsOpen(x, y))
+					{
+						nBest = nDistance;
+						node.x = x;
+						node.y = y;
+					}
+				}
+			}
 		}
 	}
+}
 
-	if (value >= RANGE_INVALID)
-		return PATH_FAIL; // no path at all	
-	
-	pos = best;
-	Block(pos, nAdjust);	
-	return PATH_CONTINUE; // ok but not reached yet
+// Fewest hops that could still reach the destination, never an overestimate
+int CTeleportPath::GetEstimate(int x, int y) const
+{
+	return (int)(sqrt((double)GetDistance2(x, y, m_ptEnd.x, m_ptEnd.y)) / (TP_RANGE + 1)) + 1;
 }
 
+/////////////////////////////////////////////////////////////////////
+// A* over the teleport graph
+//
+// Every hop costs the same, so the search finds the path with the fewest
+// teleports. Replaces the greedy "Get Best Move" walk by Niren7 and Abin,
+// which could loop or dead-end in mazes like the Arcane Sanctuary.
+/////////////////////////////////////////////////////////////////////
 DWORD CTeleportPath::FindTeleportPath(POINT ptStart, POINT ptEnd, LPPOINT lpBuffer, DWORD dwMaxCount)
 {
-	if (lpBuffer == NULL || dwMaxCount == 0 || m_nCX <= 0 || m_nCY <= 0 || m_ppTable == NULL)
+	if (lpBuffer == NULL || dwMaxCount < 2 || m_nCX <= 0 || m_nCY <= 0)
 		return 0;
 	
 	memset(lpBuffer, 0, sizeof(POINT) * dwMaxCount);
 	m_ptStart = ptStart;
 	m_ptEnd = ptEnd;
 
-	//GameInfof("start %d %d End %d %d", ptStart.x, ptStart.y, ptEnd.x, ptEnd.y);
-
-	MakeDistanceTable();
-	//DumpDistanceTable("c:\\map2.txt");
-	 
 	lpBuffer[0] = ptStart; // start point
-	DWORD dwFound = 1;
+	if (InRange(ptStart.x, ptStart.y, ptEnd.x, ptEnd.y))
+	{
+		lpBuffer[1] = ptEnd;
+		return 2;
+	}
 
-	POINT pos = ptStart;
+	MakeNodes();
+
+	const int nBlocks = m_nBlocksX * m_nBlocksY;
+	const int FROM_START = -1;
+	std::vector<int> aHops(nBlocks, RANGE_INVALID);
+	std::vector<int> aParent(nBlocks, FROM_START);
+	std::vector<bool> aClosed(nBlocks, false);
+	std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> open;
 
-	BOOL bOK = FALSE;
-	int nRes = GetBestMove(pos);
-	while (nRes != PATH_FAIL && dwFound < dwMaxCount)
+	int nReached = FROM_START;
+	POINT pos = ptStart;
+	int nHops = 0, nFrom = FROM_START;
+	for (;;)
 	{
-		// Reached?
-		if (nRes == PATH_REACHED)
+		// Queue every landing cell one teleport away from pos
+		VisitNeighbours(pos, [&](int nBlock, const POINT& node) {
+			if (aClosed[nBlock] || aHops[nBlock] <= nHops + 1)
+				return;
+
+			aHops[nBlock] = nHops + 1;
+			aParent[nBlock] = nFrom;
+			OpenNode next = { nHops + 1 + GetEstimate(node.x, node.y), GetDistance2(node.x, node.y, ptEnd.x, ptEnd.y), nBlock };
+			open.push(next);
+		});
+
+		// Take the most promising node that hasn't been expanded yet
+		OpenNode best;
+		do
 		{
-			bOK = TRUE;
-			lpBuffer[dwFound] = ptEnd;
-			dwFound++;
-			break; // Finished
-		}
-
-		// Perform a redundancy check
-		int nRedundancy = GetRedundancy(lpBuffer, dwFound, pos);
-		if (nRedundancy == -1)
+			if (open.empty())
+				return 0; // no path at all
+			best = open.top();
+			open.pop();
+		} while (aClosed[best.nBlock]);
+
+		nFrom = best.nBlock;
+		aClosed[nFrom] = true;
+		pos = m_aNodes[nFrom];
+		nHops = aHops[nFrom];
+
+		if (InRange(pos.x, pos.y, ptEnd.x, ptEnd.y))
 		{
-			// no redundancy
-			lpBuffer[dwFound] = pos;
-			dwFound++;
+			nReached = nFrom;
+			break;
 		}
-		else
-		{
-			// redundancy found, discard all redundant steps
-			dwFound = nRedundancy + 1;
-			lpBuffer[dwFound] = pos;
-		}	
+	}
 
-		nRes = GetBestMove(pos);
-	}	
+	// Start + every landing cell + the destination
+	DWORD dwFound = (DWORD)nHops + 2;
+	if (dwFound > dwMaxCount)
+		return 0;
 
-	if (!bOK)
-		dwFound = 0;
+	lpBuffer[dwFound - 1] = ptEnd;
+	DWORD i = dwFound - 2;
+	for (int nBlock = nReached; nBlock != FROM_START; nBlock = aParent[nBlock])
+		lpBuffer[i--] = m_aNodes[nBlock];
 
 	return dwFound;
 }
 
-void CTeleportPath::Block(POINT pos, int nRange)
+void CTeleportPath::RestrictTo(const std::vector<RECT>& aAreas)
 {
-	nRange = max(nRange, 1);
+	m_aAreas = aAreas;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Hop field
+//
+// A breadth first search back from the destination gives every landing
+// cell its number of teleports to the destination. Any position can
+// then find its way by stepping to the neighbour with the fewest hops,
+// which always exists, so re-planning after a missed teleport is as
+// cheap as following the path.
+/////////////////////////////////////////////////////////////////////
+BOOL CTeleportPath::MakeField(POINT ptEnd)
+{
+	if (m_nCX <= 0 || m_nCY <= 0)
+		return FALSE;
 
-	for (int i = pos.x - nRange; i < pos.x + nRange; i++)
+	m_ptEnd = ptEnd;
+	MakeNodes();
+
+	const int nBlocks = m_nBlocksX * m_nBlocksY;
+	m_aField.assign(nBlocks, RANGE_INVALID);
+	std::vector<int> aQueue;
+	aQueue.reserve(nBlocks);
+
+	VisitNeighbours(ptEnd, [&](int nBlock, const POINT&) {
+		m_aField[nBlock] = 1;
+		aQueue.push_back(nBlock);
+	});
+
+	for (size_t nHead = 0; nHead < aQueue.size(); nHead++)
 	{
-		for (int j = pos.y - nRange; j < pos.y + nRange; j++)
-		{
-			if (IsValidIndex(i, j))
-				m_ppTable[i][j] = RANGE_INVALID;
-		}
+		const int nHops = m_aField[aQueue[nHead]] + 1;
+		VisitNeighbours(m_aNodes[aQueue[nHead]], [&](int nBlock, const POINT&) {
+			if (m_aField[nBlock] != RANGE_INVALID)
+				return;
+			m_aField[nBlock] = nHops;
+			aQueue.push_back(nBlock);
+		});
 	}
+
+	return TRUE;
 }
 
-int CTeleportPath::GetRedundancy(const LPPOINT lpPath, DWORD dwMaxCount, const POINT &pos)
+DWORD CTeleportPath::FollowField(POINT ptStart, LPPOINT lpBuffer, DWORD dwMaxCount) const
 {
-	// step redundancy check
-	if (lpPath == NULL || dwMaxCount == 0)
-		return -1;
+	if (lpBuffer == NULL || dwMaxCount < 2 || m_aField.empty())
+		return 0;
 
-	for (DWORD i = 1; i < dwMaxCount; i++)
+	lpBuffer[0] = ptStart;
+	DWORD dwCount = 1;
+	POINT pos = ptStart;
+	while (!InRange(pos.x, pos.y, m_ptEnd.x, m_ptEnd.y))
 	{
-		if (AutoTele::GetDistanceSquared(lpPath[i].x, lpPath[i].y, pos.x, pos.y) <= TP_RANGE / 2)
-			return i;
+		int nBest = -1, nBestHops = RANGE_INVALID, nBestDistance = 0;
+		VisitNeighbours(pos, [&](int nBlock, const POINT& node) {
+			int nDistance = GetDistance2(node.x, node.y, m_ptEnd.x, m_ptEnd.y);
+			if (m_aField[nBlock] < nBestHops || (m_aField[nBlock] == nBestHops && nDistance < nBestDistance))
+			{
+				nBest = nBlock;
+				nBestHops = m_aField[nBlock];
+				nBestDistance = nDistance;
+			}
+		});
+
+		if (nBest < 0 || dwCount + 1 >= dwMaxCount)
+			return 0; // cut off from the destination, or too long
+
+		pos = m_aNodes[nBest];
+		lpBuffer[dwCount++] = pos;
 	}
 
-	return -1;
+	lpBuffer[dwCount++] = m_ptEnd;
+	return dwCount;
+}
+
+// Calls visit(block, landing cell) for every landing cell one teleport away from pos
+template <class Visit>
+void CTeleportPath::VisitNeighbours(POINT pos, Visit visit) const
+{
+	int nMinX = max(0, (int)(pos.x - TP_RANGE) / TP_BLOCK), nMaxX = min(m_nBlocksX - 1, (int)(pos.x + TP_RANGE) / TP_BLOCK);
+	int nMinY = max(0, (int)(pos.y - TP_RANGE) / TP_BLOCK), nMaxY = min(m_nBlocksY - 1, (int)(pos.y + TP_RANGE) / TP_BLOCK);
+	for (int bx = nMinX; bx <= nMaxX; bx++)
+	{
+		for (int by = nMinY; by <= nMaxY; by++)
+		{
+			int nBlock = by * m_nBlocksX + bx;
+			const POINT& node = m_aNodes[nBlock];
+			if (node.x >= 0 && InRange(pos.x, pos.y, node.x, node.y))
+				visit(nBlock, node);
+		}
+	}
 }
 
 BOOL CTeleportPath::IsValidIndex(int x, int y) const
@@ -235,43 +381,39 @@ BOOL CTeleportPath::IsValidIndex(int x, int y) const
 	return x >= 0 && x < m_nCX && y >= 0 && y < m_nCY;
 }
 
-/*BOOL CTeleportPath::DumpDistanceTable(LPCSTR lpszFilePath) const
+int CTeleportPath::GetDistance2(int x1, int y1, int x2, int y2)
 {
-	if (lpszFilePath == NULL || m_ppTable == NULL)
-		return FALSE;
+	return (x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2);
+}
 
-	FILE *fp = fopen(lpszFilePath, "w+");
-	if(fp == NULL )
-		return FALSE;
+// Same test as AutoTele::GetDistanceSquared(...) <= TP_RANGE, which rounds the distance down
+BOOL CTeleportPath::InRange(int x1, int y1, int x2, int y2)
+{
+	return GetDistance2(x1, y1, x2, y2) < (TP_RANGE + 1) * (TP_RANGE + 1);
+}
 
-	for (int y = 0; y < m_nCY; y++)
-	{
-		for (int x = 0; x < m_nCX; x++)
-		{
-			if (m_ptStart.x == x && m_ptStart.y == y)
-			{
-				fprintf(fp, "%s ", "St");
-			}
-			else if (m_ptEnd.x == x && m_ptEnd.y == y)
-			{
-				fprintf(fp, "%s ", "En");
-			}
-			else
-			{
-				short iDis = m_ppTable[x][y];
-
-				if (iDis == RANGE_INVALID)
-					fprintf(fp, "%s ", "  ");
-				else if (iDis >= 255)
-					fprintf(fp, "%s ", "??");
-				else
-					fprintf(fp, "%02X ", iDis);		
-			}					
-		}
+//////////////////////////////////////////////////////////////////////
+// CTeleportField
+//////////////////////////////////////////////////////////////////////
 
-		fprintf(fp, "%c", '\n');
-	}
+CTeleportField::CTeleportField(PathGridPtr pGrid, POINT ptOrigin, POINT ptEnd)
+	: m_pGrid(pGrid), m_path(*pGrid), m_ptOrigin(ptOrigin), m_ptEnd(ptEnd)
+{
+	POINT ptRelative = { ptEnd.x - ptOrigin.x, ptEnd.y - ptOrigin.y };
+	m_path.MakeField(ptRelative);
+}
 
-	fclose(fp);
-	return TRUE;
-}*/
+DWORD CTeleportField::FindPath(POINT ptStart, LPPOINT lpBuffer, DWORD dwMaxCount) const
+{
+	POINT ptRelative = { ptStart.x - m_ptOrigin.x, ptStart.y - m_ptOrigin.y };
+	if (!m_pGrid->IsValidIndex(ptRelative.x, ptRelative.y))
+		return 0;
+
+	DWORD dwCount = m_path.FollowField(ptRelative, lpBuffer, dwMaxCount);
+	for (DWORD i = 0; i < dwCount; i++)
+	{
+		lpBuffer[i].x += m_ptOrigin.x;
+		lpBuffer[i].y += m_ptOrigin.y;
+	}
+	return dwCount;
+}
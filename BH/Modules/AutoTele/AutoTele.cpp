@@ -1,7 +1,9 @@
 #include "AutoTele.h"
 #include "../../BH.h"
+#include "../../PresetCache.h"
 #include "ATIncludes\CMapIncludes.h"
 #include "ATIncludes\Vectors.h"
+#include <mutex>
 
 #define VALIDPTR(x) ( (x) && (!IsBadReadPtr(x,sizeof(x))) )
 
@@ -9,6 +11,16 @@ int waypoints[] = {119,157,156,323,288,402,324,237,238,398,496,511,494};
 int CSID = 0;
 int CS[] = {392, 394, 396, 255};
 
+// Collision maps outlive a single teleport, they're only rebuilt when the areas change
+CCollisionMapCache g_mapCache;
+
+// Filled in by the pool as each field finishes. A new set replaces the old
+// one on every level change, late tasks of the old set are just ignored.
+struct VectorFieldSet {
+	std::mutex lock;
+	std::shared_ptr<const CTeleportField> fields[5];
+};
+
 
 using namespace Drawing;
 
@@ -69,6 +81,7 @@ void AutoTele::LoadConfig() {
 	BH::config->ReadToggle("Draw Destination", "None", true, Toggles["Draw Destination"]);
 	BH::config->ReadToggle("Fast Teleport", "None", true, Toggles["Fast Teleport"]);
 	BH::config->ReadToggle("Quest Drop Warning", "None", false, Toggles["Quest Drop Warning"]);
+	BH::config->ReadToggle("Dump Collision Maps", "None", false, Toggles["Dump Collision Maps"]);
 
 	BH::config->ReadKey("Next Tele", "VK_NUMPAD0", NextKey);
 	BH::config->ReadKey("Other Tele", "VK_NUMPAD1", OtherKey);
@@ -129,6 +142,14 @@ void AutoTele::OnLoop() {
 		//return;
 	}
 
+	//rooms keep loading after we enter, redo the fields when the map grows
+	if(VectorAreaCount && !TPath.GetSize() && GetTickCount() - VectorTimer > 1000) {
+		VectorTimer = GetTickCount();
+		CCollisionMap* map = g_mapCache.GetMap(VectorAreas, VectorAreaCount);
+		if(map && map->GetRevision() != VectorRevision)
+			PrecomputePaths(map);
+	}
+
 	if(LastArea == MAP_A4_THE_CHAOS_SANCTUARY)
 		if(vVector[LastArea*4].Id2 != (1337+CSID)) {
 			vVector[LastArea*4].Id2 = 1337+CSID;
@@ -138,7 +159,7 @@ void AutoTele::OnLoop() {
 	if(TPath.GetSize()) {
 		End = TPath.GetLast();
 
-		if(SetTele) {
+		if(SetTele && !WalkRoute) {
 			if(!SetSkill(0x36, 0)) {	//0x36 is teleport
 				TPath.RemoveAll();
 				PrintText(1, "c4AutoTele:c1 Failed to set teleport!");
@@ -147,7 +168,7 @@ void AutoTele::OnLoop() {
 			SetTele = 0;
 		}
 
-		if(D2CLIENT_GetPlayerUnit()->pInfo->pRightSkill->pSkillInfo->wSkillId == 0x36) {
+		if(WalkRoute || D2CLIENT_GetPlayerUnit()->pInfo->pRightSkill->pSkillInfo->wSkillId == 0x36) {	//walking needs no skill
 			TeleActive = 1;
 		} else {
 			if(TeleActive) {
@@ -164,43 +185,28 @@ void AutoTele::OnLoop() {
 			return;
 		}
 
-		if(CastTele) {
-			CastTele = 0;
-			_timer2 = GetTickCount();
-			if(!CastOnMap(static_cast<WORD>(TPath.ElementAt(0).x),static_cast<WORD>(TPath.ElementAt(0).y), false)) {
-				TPath.RemoveAll();
-				return;
-			}
-		}
+		if(CastTele && !CastNext())
+			return;
 
-		if((GetTickCount() - _timer2) > 500) {
+		//only reached when the server never confirmed the hop
+		if((GetTickCount() - _timer2) > (DWORD)(WalkRoute ? 2000 : 500)) {	//walking a waypoint takes a while
 			if(Try >= 5) {
-				PrintText(1, "c4AutoTele:c1 Failed to teleport after 5 tries");
+				PrintText(1, "c4AutoTele:c1 Failed to %s after 5 tries", WalkRoute ? "walk" : "teleport");
 				TPath.RemoveAll();
 				Try = 0;
 				DoInteract = 0;
 				return;
 			} else {
 				Try++;
+				Replan();	//we may have landed somewhere else, carry on from there
 				CastTele = 1;
 				return;
 			}
 		}
 
-		if(GetDistanceSquared(D2CLIENT_GetUnitX(D2CLIENT_GetPlayerUnit()), D2CLIENT_GetUnitY(D2CLIENT_GetPlayerUnit()), TPath.ElementAt(0).x, TPath.ElementAt(0).y) <= 5) {
-			TPath.RemoveAt(0, 1);
-			CastTele = 1;
-		}
-			
-		if(DoInteract) {
-			if(GetDistanceSquared(D2CLIENT_GetUnitX(D2CLIENT_GetPlayerUnit()), D2CLIENT_GetUnitY(D2CLIENT_GetPlayerUnit()), End.x, End.y) <= 5) {
-				_InteractTimer = GetTickCount();
-				InteractId = GetUnitByXY(End.x, End.y, InteractRoom);
-				SetInteract = 1;
-				TPath.RemoveAll();
-				return;
-			}
-		}
+		//walking, or a reassign packet we didn't get
+		POINT pos = {(LONG)D2CLIENT_GetUnitX(D2CLIENT_GetPlayerUnit()), (LONG)D2CLIENT_GetUnitY(D2CLIENT_GetPlayerUnit())};
+		Arrive(pos);
 	} else {
 		End.x = 0;
 		End.y = 0;
@@ -234,10 +240,18 @@ void AutoTele::OnKey(bool up, BYTE key, LPARAM lParam, bool* block) {
 
 void AutoTele::OnGamePacketRecv(BYTE* packet, bool* block) {
 
+	// 0x15 [BYTE Unit Type] [DWORD Unit Id] [WORD X] [WORD Y] [BYTE Reassign]
 	if(packet[0] == 0x15) { 
 		if(*(DWORD*)&packet[2] == D2CLIENT_GetPlayerUnit()->dwUnitId) {
 			packet[10] = 0;  
 
+			//the server has us on the new spot, start the next hop without waiting for the loop
+			if(TPath.GetSize() && TeleActive) {
+				POINT pos = {*(WORD*)&packet[6], *(WORD*)&packet[8]};
+				if(Arrive(pos) && CastTele && TPath.GetSize())
+					CastNext();
+			}
+
 			//if(Toggles["Fast Teleport"].state) {
 			//	UnitAny* Me = D2CLIENT_GetPlayerUnit();
 
@@ -252,9 +266,33 @@ void AutoTele::OnGamePacketRecv(BYTE* packet, bool* block) {
 			//}
 		}
 	}
+
+	// 0x23 [BYTE Unit Type] [DWORD Unit Id] [BYTE Hand] [WORD Skill] [DWORD Item Id]
+	if(packet[0] == 0x23 && TPath.GetSize() && !WalkRoute && !TeleActive) {
+		//teleport is on the right hand, cast the first hop now instead of on the next loop
+		if(*(DWORD*)&packet[2] == D2CLIENT_GetPlayerUnit()->dwUnitId && packet[6] == 0 && *(WORD*)&packet[7] == 0x36) {
+			TeleActive = 1;
+			if(CastTele)
+				CastNext();
+		}
+	}
 	return;
 }
 
+void AutoTele::OnGameExit() {
+	// The cached maps point at rooms of the game we just left
+	g_mapCache.Clear();
+	TPath.RemoveAll();
+	FieldCancel.Cancel();
+	Field.reset();
+	FieldTask = std::future<std::shared_ptr<const CTeleportField>>();
+	WalkRoute.reset();
+	VectorCancel.Cancel();
+	VectorFields.reset();
+	VectorAreaCount = 0;
+	LastArea = 0;
+}
+
 void AutoTele::GetVectors() {
 	DWORD MyArea = GetPlayerArea();
 	DWORD Areas[2] = {MyArea, 0};
@@ -275,10 +313,12 @@ void AutoTele::GetVectors() {
 		}
 	}
 
-	CCollisionMap g_collisionMap;
-	if (buildCollisionMap) {
-		buildCollisionMap = g_collisionMap.CreateMap(Areas, AreaCount);  //create a cmap for the current area
-	}
+	//the paths to every vector are worked out up front, so the map is always needed
+	CCollisionMap* g_collisionMap = g_mapCache.GetMap(Areas, AreaCount);  //get the cmap for the current area
+	buildCollisionMap = buildCollisionMap && g_collisionMap != NULL;
+	VectorAreas[0] = Areas[0];
+	VectorAreas[1] = Areas[1];
+	VectorAreaCount = g_collisionMap ? AreaCount : 0;
 
   // hack to reset 'other extra'
   Vectors[4].x = 0;
@@ -318,7 +358,7 @@ void AutoTele::GetVectors() {
 
 			LPLevelExit ExitArray[0x40];//declare an array of exits to store the exits in later
 
-			int ExitCount = g_collisionMap.GetLevelExits(ExitArray); //getlevelexits returns the exitcount
+			int ExitCount = g_collisionMap->GetLevelExits(ExitArray); //getlevelexits returns the exitcount
 
 			if(!ExitCount)//if there are 0 tele positions we can stop here :p
 				continue;
@@ -336,6 +376,75 @@ void AutoTele::GetVectors() {
 			}
 		}
 	}
+
+	PrecomputePaths(g_collisionMap);
+	if (Toggles["Dump Collision Maps"].state)
+		SaveMapDump(g_collisionMap);
+}
+
+// Writes the map to maps\<seed>_<area>.bhm so path finding changes can be
+// tried on real levels outside the game. The copy is taken here, only the
+// file is written on the pool.
+void AutoTele::SaveMapDump(CCollisionMap* map) {
+	UnitAny* player = D2CLIENT_GetPlayerUnit();
+	if (!map || !player || !player->pAct)
+		return;
+
+	auto dump = std::make_shared<CMapDump>();
+	if (!map->CopyMapDump(*dump))
+		return;
+
+	char szName[64];
+	sprintf_s(szName, sizeof(szName), "%08X", player->pAct->dwMapSeed);
+	std::string file = BH::path + "maps\\" + szName;
+	for (size_t i = 0; i < dump->aLevels.size(); i++)
+		file += "_" + std::to_string((long long)dump->aLevels[i]);
+	file += ".bhm";
+
+	Task::Run([=]() -> void {
+		CreateDirectory((BH::path + "maps\\").c_str(), NULL);
+		dump->Save(file.c_str());
+	}, Task::Background);
+}
+
+void AutoTele::PrecomputePaths(CCollisionMap* map) {
+	VectorCancel.Cancel();
+	VectorCancel = Task::CancellationToken();
+	VectorFields = std::make_shared<VectorFieldSet>();
+
+	PathGridPtr grid = map ? map->GetPathGrid() : PathGridPtr();
+	if(!grid)
+		return;
+
+	VectorRevision = map->GetRevision();
+	if(!GetSkill(0x36))
+		return;	//the fields are teleport hops, walking trips are planned as they start
+	POINT origin = map->GetMapOrigin();
+	std::shared_ptr<VectorFieldSet> fields = VectorFields;
+	for(int i = 0;i<5;i++) {
+		if(!Vectors[i].x || !Vectors[i].y)
+			continue;
+
+		POINT target = Vectors[i];
+		Task::Run([=]() -> void {
+			std::shared_ptr<const CTeleportField> field = std::make_shared<CTeleportField>(grid, origin, target);
+			std::lock_guard<std::mutex> guard(fields->lock);
+			fields->fields[i] = field;
+		}, Task::Background, VectorCancel);
+	}
+}
+
+std::shared_ptr<const CTeleportField> AutoTele::GetVectorField(POINT target) {
+	if(!VectorFields)
+		return std::shared_ptr<const CTeleportField>();
+
+	std::lock_guard<std::mutex> guard(VectorFields->lock);
+	for(int i = 0;i<5;i++) {
+		const std::shared_ptr<const CTeleportField>& field = VectorFields->fields[i];
+		if(field && field->GetEnd().x == target.x && field->GetEnd().y == target.y)
+			return field;
+	}
+	return std::shared_ptr<const CTeleportField>();
 }
 
 Level* AutoTele::GetLevel(Act* pAct, int level) {
@@ -391,14 +500,14 @@ void AutoTele::ManageTele(Vector T) {
 	DoInteract = 0;
 
 	if(T.dwType == EXIT) {
-		CCollisionMap g_collisionMap;	//init the collisionmap
+		CCollisionMap* g_collisionMap = g_mapCache.GetMap(Areas, AreaCount);	//get the cmap for the current area
 
-		if(!g_collisionMap.CreateMap(Areas, AreaCount))		//create a cmap for the current area
+		if(!g_collisionMap)
 			return;
 
 		LPLevelExit ExitArray[0x40];	//declare an array of exits to store the exits in later
 
-		int ExitCount = g_collisionMap.GetLevelExits(ExitArray);	//getlevelexits returns the exitcount
+		int ExitCount = g_collisionMap->GetLevelExits(ExitArray);	//getlevelexits returns the exitcount
 
 		if(!ExitCount)		//if there are 0 tele positions we can stop here :p
 			return;
@@ -487,38 +596,75 @@ void AutoTele::PrintText(DWORD Color, char *szText, ...) {
 }
 
 int AutoTele::MakePath(int x, int y, DWORD Areas[], DWORD count, bool MoveThrough) {
-	CCollisionMap g_collisionMap; //init the collisionmap
-	DWORD dwCount;
+	CCollisionMap* g_collisionMap = g_mapCache.GetMap(Areas, count); //get the cmap, built on first use
+	DWORD dwCount = 0;
 	POINT aPath[255];
 
-	if(!g_collisionMap.CreateMap(Areas, count))
+	if(!g_collisionMap)
 		return false;
 
 	POINT ptStart = {D2CLIENT_GetPlayerUnit()->pPath->xPos, D2CLIENT_GetPlayerUnit()->pPath->yPos};
 	POINT ptEnd = {x, y};
 
-	if(!g_collisionMap.IsValidAbsLocation(ptStart.x, ptStart.y))
+	if(!g_collisionMap->IsValidAbsLocation(ptStart.x, ptStart.y))
 		return false;
 
-	if(!g_collisionMap.IsValidAbsLocation(ptEnd.x, ptEnd.y))
+	if(!g_collisionMap->IsValidAbsLocation(ptEnd.x, ptEnd.y))
 		return false;
 
-	g_collisionMap.AbsToRelative(ptStart);
-	g_collisionMap.AbsToRelative(ptEnd);
-
-	WordMatrix matrix;
+	PathGridPtr grid = g_collisionMap->GetPathGrid();
 
-	if(!g_collisionMap.CopyMapData(matrix))
+	if(!grid)
 		return false;
 
-	CTeleportPath tf(matrix.GetData(), matrix.GetCX(), matrix.GetCY());
-	dwCount = tf.FindTeleportPath(ptStart, ptEnd, aPath, 255);
+	std::shared_ptr<const CTeleportField> precomputed;
+	std::shared_ptr<const CWalkRoute> route;
+	if(!GetSkill(0x36)) {
+		//no teleport, walk there through the rooms between us and the destination
+		POINT ptFrom = ptStart, ptTo = ptEnd;
+		g_collisionMap->AbsToRelative(ptFrom);
+		g_collisionMap->AbsToRelative(ptTo);
+
+		RoomGraphPtr rooms = g_collisionMap->GetRoomGraph();
+		std::vector<RECT> corridor;
+		if(!rooms || !rooms->FindCorridor(ptFrom, ptTo, corridor))
+			corridor.clear();
+
+		route = std::make_shared<CWalkRoute>(grid, g_collisionMap->GetMapOrigin(), ptEnd, corridor);
+		dwCount = route->FindPath(ptStart, aPath, 254);
+		if(dwCount == 0)
+			return false;
+	} else {
+		//a path to one of the vectors is already worked out, just follow it from here
+		precomputed = GetVectorField(ptEnd);
+		if(precomputed)
+			dwCount = precomputed->FindPath(ptStart, aPath, 255);
+	}
 
-	if(dwCount == 0)
-		return false;
+	if(dwCount == 0) {
+		g_collisionMap->AbsToRelative(ptStart);
+		g_collisionMap->AbsToRelative(ptEnd);
 
-	for(DWORD i = 0;i < dwCount;i++) {
-		g_collisionMap.RelativeToAbs(aPath[i]);
+		CTeleportPath tf(*grid);
+
+		//search the rooms between us and the destination first, the whole map if that fails
+		RoomGraphPtr rooms = g_collisionMap->GetRoomGraph();
+		std::vector<RECT> corridor;
+		if(rooms && rooms->FindCorridor(ptStart, ptEnd, corridor)) {
+			tf.RestrictTo(corridor);
+			dwCount = tf.FindTeleportPath(ptStart, ptEnd, aPath, 255);
+			tf.RestrictTo(std::vector<RECT>());
+		}
+
+		if(dwCount == 0)
+			dwCount = tf.FindTeleportPath(ptStart, ptEnd, aPath, 255);
+
+		if(dwCount == 0)
+			return false;
+
+		for(DWORD i = 0;i < dwCount;i++) {
+			g_collisionMap->RelativeToAbs(aPath[i]);
+		}
 	}
 
 	if(MoveThrough) {
@@ -546,9 +692,99 @@ int AutoTele::MakePath(int x, int y, DWORD Areas[], DWORD count, bool MoveThroug
 	for(DWORD i = 0;i<dwCount;i++)
 		TPath.Add(aPath[i], 1);
 
+	FieldCancel.Cancel();
+	FieldCancel = Task::CancellationToken();
+	Field.reset();
+	WalkRoute = route;
+	if(WalkRoute)
+		return dwCount;	//walks are re-planned from the route, there's no field to build
+
+	if(precomputed && precomputed->GetEnd().x == aPath[dwCount-1].x && precomputed->GetEnd().y == aPath[dwCount-1].y) {
+		Field = precomputed;	//the vector's field doubles as the one for re-planning
+		return dwCount;
+	}
+
+	// The hop field takes longer than the path, build it off the game thread
+	// from the same read-only snapshot in case we have to re-plan on the way
+	POINT ptOrigin = g_collisionMap->GetMapOrigin();
+	POINT ptGoal = aPath[dwCount-1];
+	FieldTask = Task::Run([=]() -> std::shared_ptr<const CTeleportField> {
+		return std::make_shared<CTeleportField>(grid, ptOrigin, ptGoal);
+	}, Task::Background, FieldCancel);
+
 	return dwCount;
 }
 
+bool AutoTele::CastNext() {
+	CastTele = 0;
+	_timer2 = GetTickCount();
+	WORD x = static_cast<WORD>(TPath.ElementAt(0).x), y = static_cast<WORD>(TPath.ElementAt(0).y);
+	if(!(WalkRoute ? MoveOnMap(x, y) : CastOnMap(x, y, false))) {
+		TPath.RemoveAll();
+		return false;
+	}
+	return true;
+}
+
+// Called with where we stand. Drops the hop we were going for once we're on
+// it, or finishes the trip at the destination. False if we're on neither.
+bool AutoTele::Arrive(POINT pos) {
+	POINT last = TPath.GetLast();
+	if(DoInteract && GetDistanceSquared(pos.x, pos.y, last.x, last.y) <= 5) {
+		InteractId = GetUnitByXY(last.x, last.y, InteractRoom);
+		TPath.RemoveAll();
+		if(InteractId) {
+			Interact(InteractId, InteractType);	//the server already has us next to it
+			return true;
+		}
+		//not in the unit list yet, leave it to the delayed interact
+		_InteractTimer = GetTickCount();
+		SetInteract = 1;
+		return true;
+	}
+
+	if(GetDistanceSquared(pos.x, pos.y, TPath.ElementAt(0).x, TPath.ElementAt(0).y) > 5)
+		return false;
+
+	TPath.RemoveAt(0, 1);
+	CastTele = 1;
+	return true;
+}
+
+bool AutoTele::Replan() {
+	POINT aPath[255];
+	POINT ptStart = {D2CLIENT_GetPlayerUnit()->pPath->xPos, D2CLIENT_GetPlayerUnit()->pPath->yPos};
+	DWORD dwCount = 0;
+
+	if(WalkRoute) {
+		//walking is cheap enough to plan again from wherever we got stuck
+		dwCount = WalkRoute->FindPath(ptStart, aPath, 254);
+		if(dwCount >= 2 && (WalkRoute->GetEnd().x != End.x || WalkRoute->GetEnd().y != End.y))
+			aPath[dwCount++] = End;	//keep the step through the exit
+	} else {
+		if(!Field && FieldTask.valid() && FieldTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+			try {
+				Field = FieldTask.get();
+			} catch (...) {
+			}
+		}
+
+		if(!Field || Field->GetEnd().x != End.x || Field->GetEnd().y != End.y)
+			return false;
+
+		dwCount = Field->FindPath(ptStart, aPath, 255);
+	}
+	if(dwCount < 2)
+		return false;
+
+	//the first point is where we stand
+	TPath.RemoveAll();
+	for(DWORD i = 1;i<dwCount;i++)
+		TPath.Add(aPath[i], 1);
+
+	return true;
+}
+
 POINT AutoTele::FindPresetLocation(DWORD dwType, DWORD dwTxtFileNo, DWORD Area)
 {
 	UnitAny* player = D2CLIENT_GetPlayerUnit();
@@ -562,60 +798,38 @@ POINT AutoTele::FindPresetLocation(DWORD dwType, DWORD dwTxtFileNo, DWORD Area)
 	if(!VALIDPTR(pLevel))
 		return loc;
 
-	bool bAddedRoom = false;
-	bool stoploop = false;
-	for(Room2 *pRoom = pLevel->pRoom2First; pRoom; pRoom = pRoom->pRoom2Next)
-	{
-		bAddedRoom = false;
-		if(!VALIDPTR(pRoom->pPreset) && !VALIDPTR(pRoom->pRoomTiles) && !VALIDPTR(pRoom->pRoom1))
-		{
-			D2COMMON_AddRoomData(player->pAct, pLevel->dwLevelNo, pRoom->dwPosX, pRoom->dwPosY, player->pPath->pRoom1);
-			bAddedRoom = true;
-		}
+	// Presets are shared with the maphack, so this is usually already cached
+	PresetListPtr presets = PresetCache::Get(pLevel);
+	if(!presets)
+		return loc;
 
-		for(PresetUnit* pUnit = pRoom->pPreset; pUnit; pUnit = pUnit->pPresetNext)
+	for(auto pUnit = presets->begin(); pUnit != presets->end(); pUnit++)
+	{
+		if(((dwType == NULL) || (dwType == pUnit->type)) && (dwTxtFileNo == pUnit->txtFileNo))
 		{
-			//PrintText(4, "X: %d, Y: %d, TxtFileNo: %d, Type: %d", pUnit->dwPosX, pUnit->dwPosY, pUnit->dwTxtFileNo, pUnit->dwType);
-			if(((dwType == NULL) || (dwType == pUnit->dwType)) && (dwTxtFileNo == pUnit->dwTxtFileNo))
+			if(dwType == UNIT_TILE || (dwType == UNIT_OBJECT && dwTxtFileNo == 298))
 			{
-				if(dwType == UNIT_TILE || (dwType == UNIT_OBJECT && dwTxtFileNo == 298))
-				{
-					InteractRoom = pRoom;
-					InteractType = dwType;
-					//DoInteract = 1;
-				}
+				InteractRoom = PresetCache::FindRoom(pLevel, *pUnit);
+				InteractType = dwType;
+				//DoInteract = 1;
+			}
 
-				if(dwType == UNIT_OBJECT)
+			if(dwType == UNIT_OBJECT)
+			{
+				for(int i = 0;i <= 13;i++)
 				{
-					for(int i = 0;i <= 13;i++)
+					if(waypoints[i] == dwTxtFileNo)
 					{
-						if(waypoints[i] == dwTxtFileNo)
-						{
-							InteractRoom = pRoom;
-							InteractType = dwType;
-							//DoInteract = 1;
-							stoploop = 1;//stop looping over the rooms
-							break;
-						}
+						InteractRoom = PresetCache::FindRoom(pLevel, *pUnit);
+						InteractType = dwType;
+						//DoInteract = 1;
+						break;
 					}
 				}
-
-				loc.x = (pUnit->dwPosX) + (pRoom->dwPosX * 5);
-				loc.y = (pUnit->dwPosY) + (pRoom->dwPosY * 5);
-
-				stoploop = 1;//stop looping over the rooms
-				break;
 			}
-		}
 
-		if(bAddedRoom)
-		{
-			D2COMMON_RemoveRoomData(D2CLIENT_GetPlayerUnit()->pAct, pLevel->dwLevelNo, pRoom->dwPosX, pRoom->dwPosY, D2CLIENT_GetPlayerUnit()->pPath->pRoom1);
-			bAddedRoom = false;
-		}
-		if(stoploop)
-		{
-			stoploop = 0;
+			loc.x = pUnit->x;
+			loc.y = pUnit->y;
 			break;
 		}
 	}
@@ -668,6 +882,16 @@ bool AutoTele::CastOnMap(WORD x, WORD y, bool Left) {
 	return 1;
 }
 
+bool AutoTele::MoveOnMap(WORD x, WORD y) {
+	BYTE aPacket[5];
+	aPacket[0] = 0x03;	//run to location
+	*(WORD*)&aPacket[1] = x;
+	*(WORD*)&aPacket[3] = y;
+	D2NET_SendPacket(5, 0, aPacket);
+
+	return 1;
+}
+
 bool AutoTele::Interact(DWORD UnitId, DWORD UnitType) {
 	LPBYTE aPacket = new BYTE[9];
 	*(BYTE*)&aPacket[0] = (BYTE)0x13;
@@ -4,7 +4,15 @@
 #include "../Module.h"
 #include "../../Drawing.h"
 #include "../../Config.h"
+#include "../../Task.h"
 #include "ATIncludes\ArrayEx.h"
+#include <future>
+#include <memory>
+
+class CTeleportField;
+class CWalkRoute;
+class CCollisionMap;
+struct VectorFieldSet;
 
 typedef struct Vector_t
 {
@@ -32,24 +40,46 @@ class AutoTele : public Module {
 		CArrayEx <POINT, POINT> TPath;
 		HANDLE LoadHandle;
 
+		// Hop field to the end of TPath, built on the pool after each MakePath
+		std::shared_ptr<const CTeleportField> Field;
+		std::future<std::shared_ptr<const CTeleportField>> FieldTask;
+		Task::CancellationToken FieldCancel;
+
+		// Set instead of Field when the character can't teleport and walks TPath
+		std::shared_ptr<const CWalkRoute> WalkRoute;
+
+		// Hop fields to each of the Vectors, built on the pool on level entry
+		std::shared_ptr<VectorFieldSet> VectorFields;
+		Task::CancellationToken VectorCancel;
+		DWORD VectorAreas[2], VectorAreaCount;
+		DWORD VectorRevision, VectorTimer;
+
 		//functions
 		DWORD GetPlayerArea();
 		void ManageTele(Vector T);
 		int MakePath(int x, int y, DWORD Areas[], DWORD count, bool MoveThrough);
+		bool Replan();
+		bool CastNext();
+		bool Arrive(POINT pos);
+		void PrecomputePaths(CCollisionMap* map);
+		void SaveMapDump(CCollisionMap* map);
+		std::shared_ptr<const CTeleportField> GetVectorField(POINT target);
 		POINT FindPresetLocation(DWORD dwType, DWORD dwTxtFileNo, DWORD Area);
 		bool GetSkill(WORD wSkillId);
 		bool SetSkill(WORD wSkillId, bool Left);
 		void PrintText(DWORD Color, char *szText, ...);
 		bool CastOnMap(WORD x, WORD y, bool Left);
+		bool MoveOnMap(WORD x, WORD y);
 		bool Interact(DWORD UnitId, DWORD UnitType);
 		DWORD GetUnitByXY(DWORD X, DWORD Y, Room2* pRoom);
 		bool WaitingForMapData();
 
 	public:
-		AutoTele() : Module("AutoTele"), LoadHandle(NULL) {};
+		AutoTele() : Module("AutoTele"), LoadHandle(NULL), VectorAreaCount(0), VectorRevision(0), VectorTimer(0) {};
 		void OnLoad();
 		void LoadConfig();
 		void OnLoop();
+		void OnGameExit();
 		void OnAutomapDraw();
 		void OnKey(bool up, BYTE key, LPARAM lParam, bool* block);
 		void OnGamePacketRecv(BYTE* packet, bool* block);
@@ -124,8 +124,6 @@ void Item::LoadConfig() {
 
 	ItemDisplay::UninitializeItemRules();
 
-	//InitializeMPQData();
-
 	BH::config->ReadKey("Show Players Gear", "VK_0", showPlayer);
 }
 
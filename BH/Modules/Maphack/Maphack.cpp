@@ -11,6 +11,7 @@
 #include "../Item/ItemDisplay.h"
 #include "../Item/Item.h"
 #include "../../AsyncDrawBuffer.h"
+#include "../../PresetCache.h"
 
 #pragma optimize( "", off)
 
@@ -25,8 +26,17 @@ Patch* fpsPatch = new Patch(NOP, D2CLIENT, { 0x44E51, 0x45EA1 }, 0, 8);
 
 DrawDirective automapDraw(true, 5);
 
+// First level id of each act, the last entry terminates act 5.
+static const int actLevelIds[6] = {1, 40, 75, 103, 109, 137};
+
+// Times an act that fails to load is queued again before it's left unrevealed
+#define REVEAL_MAX_RETRIES 3
+
 Maphack::Maphack() : Module("Maphack") {
 	revealType = MaphackRevealAct;
+	revealBudget = 4;
+	revealingAct = NULL;
+	revealingLevel = 0;
 	ResetRevealed();
 	missileColors["Player"] = 0x97;
 	missileColors["Neutral"] = 0x0A;
@@ -54,6 +64,7 @@ void Maphack::LoadConfig() {
 
 void Maphack::ReadConfig() {
 	BH::config->ReadInt("Reveal Mode", revealType);
+	BH::config->ReadInt("Reveal Budget", revealBudget);
 	BH::config->ReadInt("Show Monster Resistance", monsterResistanceThreshold);
 	BH::config->ReadInt("LK Chest Lines", lkLinesColor);
 	BH::config->ReadInt("Manaburn Monster Color", mbMonColor);
@@ -153,8 +164,10 @@ void Maphack::ReadConfig() {
 
 void Maphack::ResetRevealed() {
 	revealedGame = false;
-	for (int act = 0; act < 6; act++)
+	for (int act = 0; act < 6; act++) {
 		revealedAct[act] = false;
+		revealRetries[act] = 0;
+	}
 	for (int level = 0; level < 255; level++)
 		revealedLevel[level] = false;
 }
@@ -307,11 +320,18 @@ void Maphack::OnLoop() {
 	ResetPatches();
 	BH::settingsUI->SetVisible(Toggles["Show Settings"].state);
 
+	// Game join/exit are raised from BH's own thread and reset the queue
+	std::lock_guard<std::mutex> guard(revealLock);
+
 	// Get the player unit for area information.
 	UnitAny* unit = D2CLIENT_GetPlayerUnit();
 	if (!unit || !Toggles["Auto Reveal"].state)
 		return;
 	
+	// Always reveal the level we are standing in right away, everything
+	// else is queued and revealed a few levels per frame.
+	RevealLevel(unit->pPath->pRoom1->pRoom2->pLevel);
+
 	// Reveal the automap based on configuration.
 	switch((MaphackReveal)revealType) {
 		case MaphackRevealGame:
@@ -321,9 +341,10 @@ void Maphack::OnLoop() {
 			RevealAct(unit->pAct->dwAct + 1);
 		break;
 		case MaphackRevealLevel:
-			RevealLevel(unit->pPath->pRoom1->pRoom2->pLevel);
 		break;
 	}
+
+	ProcessRevealQueue(unit);
 }
 
 bool IsObjectChest(ObjectTxt *obj)
@@ -626,6 +647,8 @@ void Maphack::OnAutomapDraw() {
 		}
 		if (!Toggles["Display Level Names"].state)
 			return;
+		// Level names are only text, draw them grouped by font
+		automapBuffer.push([]()->void{ Drawing::TextBatch::Begin(); });
 		for (list<LevelList*>::iterator it = automapLevels.begin(); it != automapLevels.end(); it++) {
 			if (player->pAct->dwAct == (*it)->act) {
 				string tombStar = ((*it)->levelId == player->pAct->pMisc->dwStaffTombLevel) ? "\377c2*" : "\377c4";
@@ -640,14 +663,30 @@ void Maphack::OnAutomapDraw() {
 				});
 			}
 		}
+		automapBuffer.push([]()->void{ Drawing::TextBatch::End(); });
 	});
 }
 
 void Maphack::OnGameJoin() {
-	ResetRevealed();
+	{
+		std::lock_guard<std::mutex> guard(revealLock);
+		ClearRevealQueue();
+		ResetRevealed();
+	}
 	automapLevels.clear();
 }
 
+void Maphack::OnGameExit() {
+	// Unload the act being revealed now, not when the next game's OnLoop runs
+	{
+		std::lock_guard<std::mutex> guard(revealLock);
+		ClearRevealQueue();
+		ResetRevealed();
+	}
+	PresetCache::Save();
+	Skills.Clear();
+}
+
 void Squelch(DWORD Id, BYTE button) {
 	LPBYTE aPacket = new BYTE[7];	//create packet
 	*(BYTE*)&aPacket[0] = 0x5d;	
@@ -726,18 +765,17 @@ void Maphack::OnGamePacketRecv(BYTE *packet, bool *block) {
 			break;			   
 		}
 	case 0x94: {
-			BYTE Count = packet[1];
-			DWORD Id = *(DWORD*)&packet[2];
-			for(DWORD i = 0;i < Count;i++) {
-				BaseSkill S;
-				S.Skill = *(WORD*)&packet[6+(3*i)];
-				S.Level = *(BYTE*)&packet[8+(3*i)];
-				Skills[Id].push_back(S);
-			}
-			//for(vector<BaseSkill>::iterator it = Skills[Id].begin();  it != Skills[Id].end(); it++)
+			Skills.Update(packet);
+			//SkillList list;
+			//Skills.Get(*(DWORD*)&packet[2], list);
+			//for(SkillList::const_iterator it = list.begin();  it != list.end(); it++)
 			//	PrintText(1, "Skill %d, Level %d", it->Skill, it->Level);
 			break;
 		}
+	case 0x5c: {	//Player Left Game   5c [DWORD Player Id]
+			Skills.Remove(*(DWORD*)&packet[1]);
+			break;
+		}
 	case 0x5b: {	//36   Player In Game      5b [WORD Packet Length] [DWORD Player Id] [BYTE Char Type] [NULLSTRING[16] Char Name] [WORD Char Lvl] [WORD Party Id] 00 00 00 00 00 00 00 00
 			WORD lvl = *(WORD*)&packet[24];
 			DWORD Id = *(DWORD*)&packet[3];
@@ -758,7 +796,12 @@ void Maphack::RevealGame() {
 	if (revealedGame)
 		return;
 
-	// Iterate every act and reveal it.
+	UnitAny* player = D2CLIENT_GetPlayerUnit();
+	if (!player || !player->pAct)
+		return;
+
+	// Queue the act we are in first, then every other act.
+	RevealAct(player->pAct->dwAct + 1);
 	for (int act = 1; act <= ((*p_D2CLIENT_ExpCharFlag) ? 5 : 4); act++) {
 		RevealAct(act);
 	}
@@ -771,33 +814,78 @@ void Maphack::RevealAct(int act) {
 	if (act < 1 || act > 5)
 		return;
 
-	// Check if the act is already revealed
-	if (revealedAct[act])
+	// Check if the act is already revealed or waiting to be
+	if (revealedAct[act] || revealRetries[act] >= REVEAL_MAX_RETRIES)
 		return;
-
-	UnitAny* player = D2CLIENT_GetPlayerUnit();
-	if (!player || !player->pAct)
+	if (std::find(revealQueue.begin(), revealQueue.end(), act) != revealQueue.end())
 		return;
 
-	// Initalize the act incase it is isn't the act we are in.
-	int actIds[6] = {1, 40, 75, 103, 109, 137};
-	Act* pAct = D2COMMON_LoadAct(act - 1, player->pAct->dwMapSeed, *p_D2CLIENT_ExpCharFlag, 0, D2CLIENT_GetDifficulty(), NULL, actIds[act - 1], D2CLIENT_LoadAct_1, D2CLIENT_LoadAct_2);
-	if (!pAct || !pAct->pMisc)
+	revealQueue.push_back(act);
+}
+
+void Maphack::ProcessRevealQueue(UnitAny* player) {
+	if (revealQueue.empty() || !player->pAct)
 		return;
 
-	// Iterate every level for the given act.
-	for (int level = actIds[act - 1]; level < actIds[act]; level++) {
-		Level* pLevel = GetLevel(pAct, level);
+	ULONGLONG start = BHGetMicroseconds();
+	bool revealedAny = false;
+
+	// Reveal at least one level per frame, then keep going until we run
+	// out of the per-frame budget (in milliseconds).
+	while (!revealQueue.empty()) {
+		int act = revealQueue.front();
+
+		// Initalize the act incase it is isn't the act we are in.
+		if (!revealingAct) {
+			revealingAct = D2COMMON_LoadAct(act - 1, player->pAct->dwMapSeed, *p_D2CLIENT_ExpCharFlag, 0, D2CLIENT_GetDifficulty(), NULL, actLevelIds[act - 1], D2CLIENT_LoadAct_1, D2CLIENT_LoadAct_2);
+			if (!revealingAct || !revealingAct->pMisc) {
+				// Try the other acts first and come back to this one later.
+				revealingAct = NULL;
+				revealQueue.pop_front();
+				if (++revealRetries[act] < REVEAL_MAX_RETRIES)
+					revealQueue.push_back(act);
+				break;
+			}
+			revealingLevel = actLevelIds[act - 1];
+		}
+
+		// Finished every level in the act
+		if (revealingLevel >= actLevelIds[act]) {
+			D2COMMON_UnloadAct(revealingAct);
+			revealingAct = NULL;
+			revealedAct[act] = true;
+			revealQueue.pop_front();
+			continue;
+		}
+
+		int level = revealingLevel++;
+		if (revealedLevel[level])
+			continue;
+
+		Level* pLevel = GetLevel(revealingAct, level);
 		if (!pLevel)
 			continue;
 		if (!pLevel->pRoom2First)
 			D2COMMON_InitLevel(pLevel);
 		RevealLevel(pLevel);
+		revealedAny = true;
+
+		if (BHGetMicroseconds() - start >= (ULONGLONG)revealBudget * 1000)
+			break;
 	}
 
-	InitLayer(player->pPath->pRoom1->pRoom2->pLevel->dwLevelNo);
-	D2COMMON_UnloadAct(pAct);
-	revealedAct[act] = true;
+	// RevealLevel switches the automap layer, so switch back to ours.
+	if (revealedAny)
+		InitLayer(player->pPath->pRoom1->pRoom2->pLevel->dwLevelNo);
+}
+
+void Maphack::ClearRevealQueue() {
+	if (revealingAct) {
+		D2COMMON_UnloadAct(revealingAct);
+		revealingAct = NULL;
+	}
+	revealingLevel = 0;
+	revealQueue.clear();
 }
 
 void Maphack::RevealLevel(Level* level) {
@@ -811,6 +899,12 @@ void Maphack::RevealLevel(Level* level) {
 
 	InitLayer(level->dwLevelNo);
 
+	// Presets only need to be collected once per seed, difficulty and level.
+	DWORD seed = level->pMisc->pAct->dwMapSeed;
+	BYTE difficulty = D2CLIENT_GetDifficulty();
+	PresetListPtr presets = PresetCache::Find(seed, difficulty, level->dwLevelNo);
+	PresetList scanned;
+
 	// Iterate every room in the level.
 	for(Room2* room = level->pRoom2First; room; room = room->pRoom2Next) {
 		bool roomData = false;
@@ -828,72 +922,74 @@ void Maphack::RevealLevel(Level* level) {
 		//Reveal the room
 		D2CLIENT_RevealAutomapRoom(room->pRoom1, TRUE, *p_D2CLIENT_AutomapLayer);
 
-		//Reveal the presets
-		RevealRoom(room);
+		//Collect the presets if we haven't seen this level before
+		if (!presets)
+			PresetCache::ScanRoom(room, scanned);
 
 		//Remove Data if Added
 		if (roomData)
 			D2COMMON_RemoveRoomData(level->pMisc->pAct, level->dwLevelNo, room->dwPosX, room->dwPosY, room->pRoom1);
 	}
 
+	if (!presets)
+		presets = PresetCache::Store(seed, difficulty, level->dwLevelNo, scanned);
+
+	//Reveal the presets
+	RevealPresets(level, *presets);
+
 	revealedLevel[level->dwLevelNo] = true;
 }
 
-void Maphack::RevealRoom(Room2* room) {
-	//Grabs all the preset units in room.
-	for (PresetUnit* preset = room->pPreset; preset; preset = preset->pPresetNext)
+void Maphack::RevealPresets(Level* level, const PresetList& presets) {
+	//Draws all the preset units in the level.
+	for (auto preset = presets.begin(); preset != presets.end(); preset++)
 	{
 		int cellNo = -1;
 		
 		// Special NPC Check
-		if (preset->dwType == UNIT_MONSTER)
+		if (preset->type == UNIT_MONSTER)
 		{
 			// Izual Check
-			if (preset->dwTxtFileNo == 256)
+			if (preset->txtFileNo == 256)
 				cellNo = 300;
 			// Hephasto Check
-			if (preset->dwTxtFileNo == 745)
+			if (preset->txtFileNo == 745)
 				cellNo = 745;
 		// Special Object Check
-		} else if (preset->dwType == UNIT_OBJECT) {
+		} else if (preset->type == UNIT_OBJECT) {
 			// Uber Chest in Lower Kurast Check
-			if (preset->dwTxtFileNo == 580 && room->pLevel->dwLevelNo == MAP_A3_LOWER_KURAST)
+			if (preset->txtFileNo == 580 && level->dwLevelNo == MAP_A3_LOWER_KURAST)
 				cellNo = 318;
 
 			// Countess Chest Check
-			if (preset->dwTxtFileNo == 371) 
+			if (preset->txtFileNo == 371) 
 				cellNo = 301;
 			// Act 2 Orifice Check
-			else if (preset->dwTxtFileNo == 152) 
+			else if (preset->txtFileNo == 152) 
 				cellNo = 300;
 			// Frozen Anya Check
-			else if (preset->dwTxtFileNo == 460) 
+			else if (preset->txtFileNo == 460) 
 				cellNo = 1468; 
 			// Canyon / Arcane Waypoint Check
-			if ((preset->dwTxtFileNo == 402) && (room->pLevel->dwLevelNo == 46))
+			if ((preset->txtFileNo == 402) && (level->dwLevelNo == 46))
 				cellNo = 0;
 			// Hell Forge Check
-			if (preset->dwTxtFileNo == 376)
+			if (preset->txtFileNo == 376)
 				cellNo = 376;
 
 			// If it isn't special, check for a preset.
-			if (cellNo == -1 && preset->dwTxtFileNo <= 572) {
-				ObjectTxt *obj = D2COMMON_GetObjectTxt(preset->dwTxtFileNo);
+			if (cellNo == -1 && preset->txtFileNo <= 572) {
+				ObjectTxt *obj = D2COMMON_GetObjectTxt(preset->txtFileNo);
 				if (obj)
 					cellNo = obj->nAutoMap;//Set the cell number then.
 			}
-		} else if (preset->dwType == UNIT_TILE) {
-			LevelList* level = new LevelList;
-			for (RoomTile* tile = room->pRoomTiles; tile; tile = tile->pNext) {
-				if (*(tile->nNum) == preset->dwTxtFileNo) {
-					level->levelId = tile->pRoom2->pLevel->dwLevelNo;
-					break;
-				}
-			}
-			level->x = (preset->dwPosX + (room->dwPosX * 5));
-			level->y = (preset->dwPosY + (room->dwPosY * 5));
-			level->act = room->pLevel->pMisc->pAct->dwAct;
-			automapLevels.push_back(level);
+		} else if (preset->type == UNIT_TILE && preset->targetLevel) {
+			LevelList* levelExit = new LevelList;
+			levelExit->levelId = preset->targetLevel;
+			levelExit->x = preset->x;
+			levelExit->y = preset->y;
+			levelExit->act = level->pMisc->pAct->dwAct;
+			automapLevels.push_back(levelExit);
 		}
 
 		//Draw the cell if wanted.
@@ -902,8 +998,8 @@ void Maphack::RevealRoom(Room2* room) {
 			AutomapCell* cell = D2CLIENT_NewAutomapCell();
 
 			cell->nCellNo = cellNo;
-			int x = (preset->dwPosX + (room->dwPosX * 5));
-			int y = (preset->dwPosY + (room->dwPosY * 5));
+			int x = preset->x;
+			int y = preset->y;
 			cell->xPixel = (((x - y) * 16) / 10) + 1;
 			cell->yPixel = (((y + x) * 8) / 10) - 3;
 
@@ -1,8 +1,12 @@
 #pragma once
+#include <deque>
+#include <mutex>
 #include "../../D2Structs.h"
 #include "../Module.h"
 #include "../../Config.h"
 #include "../../Drawing.h"
+#include "../../PresetCache.h"
+#include "PlayerSkills.h"
 
 enum MaphackReveal {
 	MaphackRevealGame = 0,
@@ -15,11 +19,6 @@ struct LevelList {
 	unsigned int x, y, act;
 };
 
-struct BaseSkill {
-	WORD Skill;
-	BYTE Level;
-};
-
 class Maphack : public Module {
 	private:
 		int monsterResistanceThreshold;
@@ -28,7 +27,13 @@ class Maphack : public Module {
 		unsigned int revealType;
 		unsigned int maxGhostSelection;
 		unsigned int reloadConfig;
+		unsigned int revealBudget;
 		bool revealedGame, revealedAct[6], revealedLevel[255];
+		std::deque<int> revealQueue;
+		Act* revealingAct;
+		int revealingLevel;
+		int revealRetries[6];	// Failed loads of each act, it's given up on after a few
+		std::mutex revealLock;	// Reveal state, OnLoop runs on the game thread and join/exit on BH's
 		std::map<string, string> MonsterColors;
 		std::map<string, string> SuperUniqueColors;
 		std::map<string, string> MonsterLines;
@@ -43,7 +48,7 @@ class Maphack : public Module {
 		std::list<LevelList*> automapLevels;
 		map<std::string, Toggle> Toggles;
 		Drawing::UITab* settingsTab;
-		std::map<DWORD, std::vector<BaseSkill>> Skills;
+		PlayerSkills Skills;
 
 	public:
 	Maphack();
@@ -58,6 +63,7 @@ class Maphack : public Module {
 	void OnDraw();
 	void OnAutomapDraw();
 	void OnGameJoin();
+	void OnGameExit();
 	void OnGamePacketRecv(BYTE* packet, bool *block);
 
 	void ResetRevealed();
@@ -67,8 +73,10 @@ class Maphack : public Module {
 
 	void RevealGame();
 	void RevealAct(int act);
+	void ProcessRevealQueue(UnitAny* player);
+	void ClearRevealQueue();
 	void RevealLevel(Level* level);
-	void RevealRoom(Room2* room);
+	void RevealPresets(Level* level, const PresetList& presets);
 
 	static Level* GetLevel(Act* pAct, int level);
 	static AutomapLayer* InitLayer(int level);
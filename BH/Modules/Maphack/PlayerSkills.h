@@ -0,0 +1,76 @@
+#pragma once
+#include <Windows.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct BaseSkill {
+	WORD Skill;
+	BYTE Level;
+};
+
+typedef std::vector<BaseSkill> SkillList;
+
+// Base skills of the other players in the game, as sent in 0x94 packets.
+// Each packet replaces the player's list, and players are dropped when they
+// leave so the store never outgrows the current game. Packets and lookups
+// come from the game thread, but OnGameExit clears it from BH's thread.
+class PlayerSkills {
+	private:
+		std::unordered_map<DWORD, SkillList> skills;
+		mutable std::mutex lock;
+
+		const SkillList* Find(DWORD id) const {
+			auto it = skills.find(id);
+			return it == skills.end() ? NULL : &it->second;
+		}
+
+	public:
+		// 0x94 [BYTE Count] [DWORD Unit Id] Count * ([WORD Skill] [BYTE Level])
+		void Update(const BYTE* packet) {
+			BYTE count = packet[1];
+			DWORD id = *(DWORD*)&packet[2];
+			std::lock_guard<std::mutex> guard(lock);
+
+			// Reuse the existing array so repeated packets don't reallocate
+			SkillList &list = skills[id];
+			list.resize(count);
+			for (BYTE i = 0; i < count; i++) {
+				list[i].Skill = *(WORD*)&packet[6 + (3 * i)];
+				list[i].Level = *(BYTE*)&packet[8 + (3 * i)];
+			}
+		}
+
+		void Remove(DWORD id) {
+			std::lock_guard<std::mutex> guard(lock);
+			skills.erase(id);
+		}
+
+		void Clear() {
+			std::lock_guard<std::mutex> guard(lock);
+			skills.clear();
+		}
+
+		// Copies the player's skills into list, returns false if none were sent
+		bool Get(DWORD id, SkillList& list) const {
+			std::lock_guard<std::mutex> guard(lock);
+			const SkillList* found = Find(id);
+			if (!found)
+				return false;
+			list = *found;
+			return true;
+		}
+
+		// Returns the base level of the skill, or 0 if the player doesn't have it
+		BYTE GetSkillLevel(DWORD id, WORD skill) const {
+			std::lock_guard<std::mutex> guard(lock);
+			const SkillList* list = Find(id);
+			if (!list)
+				return 0;
+			for (auto it = list->begin(); it != list->end(); it++) {
+				if (it->Skill == skill)
+					return it->Level;
+			}
+			return 0;
+		}
+};
@@ -16,24 +16,24 @@ void Module::Load() {
 
 	// Hook up all the events
 	
-	__hook(&ModuleManager::OnDraw, BH::moduleManager, &Module::OnDraw, this);
-	__hook(&ModuleManager::OnAutomapDraw, BH::moduleManager, &Module::OnAutomapDraw, this);
-	__hook(&ModuleManager::OnOOGDraw, BH::moduleManager, &Module::OnOOGDraw, this);
+	__hook(&ModuleManager::OnDraw, BH::moduleManager, &Module::TimedDraw, this);
+	__hook(&ModuleManager::OnAutomapDraw, BH::moduleManager, &Module::TimedAutomapDraw, this);
+	__hook(&ModuleManager::OnOOGDraw, BH::moduleManager, &Module::TimedOOGDraw, this);
 
-	__hook(&ModuleManager::OnGameJoin, BH::moduleManager, &Module::OnGameJoin, this);
-	__hook(&ModuleManager::OnGameExit, BH::moduleManager, &Module::OnGameExit, this);
+	__hook(&ModuleManager::OnGameJoin, BH::moduleManager, &Module::TimedGameJoin, this);
+	__hook(&ModuleManager::OnGameExit, BH::moduleManager, &Module::TimedGameExit, this);
 
-	__hook(&ModuleManager::OnLoop, BH::moduleManager, &Module::OnLoop, this);
+	__hook(&ModuleManager::OnLoop, BH::moduleManager, &Module::TimedLoop, this);
 
-	__hook(&ModuleManager::OnLeftClick, BH::moduleManager, &Module::OnLeftClick, this);
-	__hook(&ModuleManager::OnRightClick, BH::moduleManager, &Module::OnRightClick, this);
-	__hook(&ModuleManager::OnKey, BH::moduleManager, &Module::OnKey, this);
+	__hook(&ModuleManager::OnLeftClick, BH::moduleManager, &Module::TimedLeftClick, this);
+	__hook(&ModuleManager::OnRightClick, BH::moduleManager, &Module::TimedRightClick, this);
+	__hook(&ModuleManager::OnKey, BH::moduleManager, &Module::TimedKey, this);
 
-	__hook(&ModuleManager::OnChatPacketRecv, BH::moduleManager, &Module::OnChatPacketRecv, this);
-	__hook(&ModuleManager::OnRealmPacketRecv, BH::moduleManager, &Module::OnRealmPacketRecv, this);
-	__hook(&ModuleManager::OnGamePacketRecv, BH::moduleManager, &Module::OnGamePacketRecv, this);
+	__hook(&ModuleManager::OnChatPacketRecv, BH::moduleManager, &Module::TimedChatPacketRecv, this);
+	__hook(&ModuleManager::OnRealmPacketRecv, BH::moduleManager, &Module::TimedRealmPacketRecv, this);
+	__hook(&ModuleManager::OnGamePacketRecv, BH::moduleManager, &Module::TimedGamePacketRecv, this);
 
-	__hook(&ModuleManager::OnChatMsg, BH::moduleManager, &Module::OnChatMsg, this);
+	__hook(&ModuleManager::OnChatMsg, BH::moduleManager, &Module::TimedChatMsg, this);
 	__hook(&Module::UserInput, this, &Module::OnUserInput, this);
 
 	active = true;
@@ -45,26 +45,92 @@ void Module::Unload() {
 		return;
 
 	// Unhook all events
-	__unhook(&ModuleManager::OnDraw, BH::moduleManager, &Module::OnDraw, this);
-	__unhook(&ModuleManager::OnAutomapDraw, BH::moduleManager, &Module::OnAutomapDraw, this);
-	__unhook(&ModuleManager::OnOOGDraw, BH::moduleManager, &Module::OnOOGDraw, this);
+	__unhook(&ModuleManager::OnDraw, BH::moduleManager, &Module::TimedDraw, this);
+	__unhook(&ModuleManager::OnAutomapDraw, BH::moduleManager, &Module::TimedAutomapDraw, this);
+	__unhook(&ModuleManager::OnOOGDraw, BH::moduleManager, &Module::TimedOOGDraw, this);
 
-	__unhook(&ModuleManager::OnGameJoin, BH::moduleManager, &Module::OnGameJoin, this);
-	__unhook(&ModuleManager::OnGameExit, BH::moduleManager, &Module::OnGameExit, this);
+	__unhook(&ModuleManager::OnGameJoin, BH::moduleManager, &Module::TimedGameJoin, this);
+	__unhook(&ModuleManager::OnGameExit, BH::moduleManager, &Module::TimedGameExit, this);
 
-	__unhook(&ModuleManager::OnLoop, BH::moduleManager, &Module::OnLoop, this);
+	__unhook(&ModuleManager::OnLoop, BH::moduleManager, &Module::TimedLoop, this);
 
-	__unhook(&ModuleManager::OnLeftClick, BH::moduleManager, &Module::OnLeftClick, this);
-	__unhook(&ModuleManager::OnRightClick, BH::moduleManager, &Module::OnRightClick, this);
-	__unhook(&ModuleManager::OnKey, BH::moduleManager, &Module::OnKey, this);
+	__unhook(&ModuleManager::OnLeftClick, BH::moduleManager, &Module::TimedLeftClick, this);
+	__unhook(&ModuleManager::OnRightClick, BH::moduleManager, &Module::TimedRightClick, this);
+	__unhook(&ModuleManager::OnKey, BH::moduleManager, &Module::TimedKey, this);
 
-	__unhook(&ModuleManager::OnChatPacketRecv, BH::moduleManager, &Module::OnChatPacketRecv, this);
-	__unhook(&ModuleManager::OnRealmPacketRecv, BH::moduleManager, &Module::OnRealmPacketRecv, this);
-	__unhook(&ModuleManager::OnGamePacketRecv, BH::moduleManager, &Module::OnGamePacketRecv, this);
+	__unhook(&ModuleManager::OnChatPacketRecv, BH::moduleManager, &Module::TimedChatPacketRecv, this);
+	__unhook(&ModuleManager::OnRealmPacketRecv, BH::moduleManager, &Module::TimedRealmPacketRecv, this);
+	__unhook(&ModuleManager::OnGamePacketRecv, BH::moduleManager, &Module::TimedGamePacketRecv, this);
 
-	__unhook(&ModuleManager::OnChatMsg, BH::moduleManager, &Module::OnChatMsg, this);
+	__unhook(&ModuleManager::OnChatMsg, BH::moduleManager, &Module::TimedChatMsg, this);
 	//__unhook(&Module::UserInput, this, &Module::OnUserInput, this);
 
 	active = false;
 	OnUnload();
-}
\ No newline at end of file
+}
+
+// The ModuleManager events are hooked to these so every handler gets timed
+void Module::TimedDraw() {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventDraw]);
+	OnDraw();
+}
+
+void Module::TimedAutomapDraw() {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventAutomapDraw]);
+	OnAutomapDraw();
+}
+
+void Module::TimedOOGDraw() {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventOOGDraw]);
+	OnOOGDraw();
+}
+
+void Module::TimedGameJoin() {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventGameJoin]);
+	OnGameJoin();
+}
+
+void Module::TimedGameExit() {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventGameExit]);
+	OnGameExit();
+}
+
+void Module::TimedLoop() {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventLoop]);
+	OnLoop();
+}
+
+void Module::TimedLeftClick(bool up, int x, int y, bool* block) {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventLeftClick]);
+	OnLeftClick(up, x, y, block);
+}
+
+void Module::TimedRightClick(bool up, int x, int y, bool* block) {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventRightClick]);
+	OnRightClick(up, x, y, block);
+}
+
+void Module::TimedKey(bool up, BYTE key, LPARAM lParam, bool* block) {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventKey]);
+	OnKey(up, key, lParam, block);
+}
+
+void Module::TimedChatPacketRecv(BYTE* packet, bool* block) {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventChatPacket]);
+	OnChatPacketRecv(packet, block);
+}
+
+void Module::TimedRealmPacketRecv(BYTE* packet, bool* block) {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventRealmPacket]);
+	OnRealmPacketRecv(packet, block);
+}
+
+void Module::TimedGamePacketRecv(BYTE* packet, bool* block) {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventGamePacket]);
+	OnGamePacketRecv(packet, block);
+}
+
+void Module::TimedChatMsg(const char* user, const char* msg, bool fromGame, bool* block) {
+	ModuleProfiler::Scope scope(timings[ModuleProfiler::EventChatMsg]);
+	OnChatMsg(user, msg, fromGame, block);
+}
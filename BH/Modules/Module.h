@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include "ModuleManager.h"
+#include "ModuleProfiler.h"
 
 using namespace std;
 
@@ -10,16 +11,32 @@ class Module {
 
 		string name;
 		bool active;
+		ModuleProfiler::EventTimings timings[ModuleProfiler::EventCount];
 
 		void Load();
 		void Unload();
 
+		void TimedDraw();
+		void TimedAutomapDraw();
+		void TimedOOGDraw();
+		void TimedGameJoin();
+		void TimedGameExit();
+		void TimedLoop();
+		void TimedLeftClick(bool up, int x, int y, bool* block);
+		void TimedRightClick(bool up, int x, int y, bool* block);
+		void TimedKey(bool up, BYTE key, LPARAM lParam, bool* block);
+		void TimedChatPacketRecv(BYTE* packet, bool* block);
+		void TimedRealmPacketRecv(BYTE* packet, bool* block);
+		void TimedGamePacketRecv(BYTE* packet, bool* block);
+		void TimedChatMsg(const char* user, const char* msg, bool fromGame, bool* block);
+
 	public:
 		Module(string name);
 		virtual ~Module();
 
 		string GetName() { return name; };
 		bool IsActive() { return active; };
+		ModuleProfiler::EventTimings& GetTimings(int event) { return timings[event]; };
 
 		// Module Events
 		virtual void OnLoad() {};
@@ -27,6 +44,8 @@ class Module {
 
 		virtual void LoadConfig() {};
 		virtual void MpqLoaded() {};
+		// MpqData flags that must be loaded before MpqLoaded is called
+		virtual unsigned int MpqDependencies() { return MPQ_ALL; };
 
 		virtual void OnLoop() {};
 
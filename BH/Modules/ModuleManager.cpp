@@ -5,7 +5,7 @@
 #include <algorithm>
 #include <iterator>
 
-ModuleManager::ModuleManager() {
+ModuleManager::ModuleManager() : mpqReady(0), modulesLoaded(false) {
 
 }
 
@@ -51,6 +51,11 @@ void ModuleManager::LoadModules() {
 	for (map<string, Module*>::iterator it = moduleList.begin(); it != moduleList.end(); ++it) {
 		(*it).second->Load();
 	}
+
+	// Data that finished loading before the modules existed is announced now
+	std::lock_guard<std::mutex> guard(mpqLock);
+	modulesLoaded = true;
+	NotifyMpqLoaded();
 }
 
 void ModuleManager::UnloadModules() {
@@ -65,9 +70,26 @@ void ModuleManager::ReloadConfig() {
 	}
 }
 
-void ModuleManager::MpqLoaded() {
+void ModuleManager::DrawProfiler() {
+	ModuleProfiler::Draw(moduleList);
+}
+
+void ModuleManager::MpqDataReady(unsigned int data) {
+	std::lock_guard<std::mutex> guard(mpqLock);
+	mpqReady |= data;
+	if (modulesLoaded) {
+		NotifyMpqLoaded();
+	}
+}
+
+// Calls MpqLoaded once on every module whose data is all ready. Must be called with mpqLock held.
+void ModuleManager::NotifyMpqLoaded() {
 	for (map<string, Module*>::iterator it = moduleList.begin(); it != moduleList.end(); ++it) {
-		(*it).second->MpqLoaded();
+		Module* module = (*it).second;
+		unsigned int needed = module->MpqDependencies();
+		if ((mpqReady & needed) == needed && mpqNotified.insert(module).second) {
+			module->MpqLoaded();
+		}
 	}
 }
 
@@ -85,6 +107,11 @@ bool ModuleManager::UserInput(wchar_t* module, wchar_t* msg, bool fromGame) {
 		return true;
 	}
 
+	if (name.compare("profile") == 0) {
+		ModuleProfiler::Command(moduleList, msg);
+		return true;
+	}
+
 	if (name.compare("save") == 0) {
 		BH::config->Write();
 		Print("c4BH:c0 Successfully saved configuration.");
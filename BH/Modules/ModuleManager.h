@@ -1,16 +1,35 @@
 #pragma once
 #include <map>
+#include <mutex>
+#include <set>
 #include <string>
 #include <Windows.h>
 
 class Module;
 using namespace std;
 
+// The startup data a module can wait for before its MpqLoaded is called
+enum MpqData {
+	MPQ_FILES = 1 << 0,		// Raw txt files and MpqVersion
+	MPQ_STATS = 1 << 1,		// StatMap, AllStatList, CharList, STAT_MAX and SKILL_MAX
+	MPQ_INVENTORY = 1 << 2,	// InventoryLayoutMap
+	MPQ_ITEMS = 1 << 3,		// ItemAttributeMap
+	MPQ_TABLES = 1 << 4,	// Tables
+	MPQ_FINISHED = 1 << 5,	// IsInitialized(), after stats, inventory and items
+	MPQ_ALL = MPQ_FILES | MPQ_STATS | MPQ_INVENTORY | MPQ_ITEMS | MPQ_TABLES | MPQ_FINISHED
+};
+
 class ModuleManager {
 	private:
 		map<string, Module*> moduleList;
 
+		std::mutex mpqLock;
+		unsigned int mpqReady;
+		bool modulesLoaded;
+		set<Module*> mpqNotified;
+
 		void FixName(std::string& name);
+		void NotifyMpqLoaded();
 
 	public:
 		ModuleManager();
@@ -24,7 +43,10 @@ class ModuleManager {
 		void LoadModules();
 		void UnloadModules();
 		void ReloadConfig();
-		void MpqLoaded();
+		void DrawProfiler();
+
+		// Called by the startup tasks as data becomes available (MpqData flags)
+		void MpqDataReady(unsigned int data);
 
 		bool UserInput(wchar_t* module, wchar_t* msg, bool fromGame);
 
@@ -0,0 +1,186 @@
+#include "ModuleProfiler.h"
+#include "Module.h"
+#include "../D2Helpers.h"
+#include "../BH.h"
+#include "../Drawing.h"
+#include <algorithm>
+#include <fstream>
+#include <intrin.h>
+#include <vector>
+
+#define PROFILE_FILE			"profile.csv"
+#define PROFILE_OVERLAY_ROWS	16
+
+namespace ModuleProfiler {
+	bool enabled = false;
+	bool overlay = false;
+
+	static const char* eventNames[EventCount] = {
+		"Loop", "Draw", "AutomapDraw", "OOGDraw", "GameJoin", "GameExit", "LeftClick",
+		"RightClick", "Key", "ChatPacket", "RealmPacket", "GamePacket", "ChatMsg"
+	};
+
+	static double TicksToMicroseconds(ULONGLONG ticks) {
+		static LARGE_INTEGER frequency = { 0 };
+		if (!frequency.QuadPart)
+			QueryPerformanceFrequency(&frequency);
+		return (double)ticks * 1000000.0 / (double)frequency.QuadPart;
+	}
+
+	static int GetBucket(ULONGLONG us) {
+		if (us < 8)
+			return (int)us;
+		unsigned long log;
+		_BitScanReverse(&log, (DWORD)min(us, 0xFFFFFFFFULL));
+		int bucket = 8 + (log - 3) * 4 + (int)((us >> (log - 2)) & 3);
+		return min(bucket, PROFILE_BUCKETS - 1);
+	}
+
+	// Largest value in microseconds that falls into the bucket
+	static double GetBucketLimit(int bucket) {
+		if (bucket < 8)
+			return bucket + 1;
+		int log = 3 + (bucket - 8) / 4, sub = (bucket - 8) % 4;
+		return (double)((4 + sub + 1) << (log - 2));
+	}
+
+	void EventTimings::Reset() {
+		count = 0;
+		totalTicks = 0;
+		maxTicks = 0;
+		memset(buckets, 0, sizeof(buckets));
+	}
+
+	void EventTimings::Record(ULONGLONG ticks) {
+		count++;
+		totalTicks += ticks;
+		if (ticks > maxTicks)
+			maxTicks = ticks;
+		buckets[GetBucket((ULONGLONG)TicksToMicroseconds(ticks))]++;
+	}
+
+	double EventTimings::GetTotalMicroseconds() const {
+		return TicksToMicroseconds(totalTicks);
+	}
+
+	double EventTimings::GetMaxMicroseconds() const {
+		return TicksToMicroseconds(maxTicks);
+	}
+
+	double EventTimings::GetPercentile(double fraction) const {
+		if (count == 0)
+			return 0;
+		DWORD target = (DWORD)(fraction * count), seen = 0;
+		for (int i = 0; i < PROFILE_BUCKETS; i++) {
+			seen += buckets[i];
+			if (seen > target)
+				return min(GetBucketLimit(i), GetMaxMicroseconds());
+		}
+		return GetMaxMicroseconds();
+	}
+
+	const char* GetEventName(int event) {
+		return event >= 0 && event < EventCount ? eventNames[event] : "";
+	}
+
+	struct ProfileRow {
+		std::string module;
+		int event;
+		const EventTimings* timings;
+	};
+
+	// Every event that was called at least once, most expensive first
+	static std::vector<ProfileRow> GetRows(const std::map<std::string, Module*>& modules) {
+		std::vector<ProfileRow> rows;
+		for (auto it = modules.begin(); it != modules.end(); it++) {
+			for (int event = 0; event < EventCount; event++) {
+				const EventTimings& timings = it->second->GetTimings(event);
+				if (timings.GetCount() > 0) {
+					ProfileRow row = { it->first, event, &timings };
+					rows.push_back(row);
+				}
+			}
+		}
+		std::sort(rows.begin(), rows.end(), [](const ProfileRow& a, const ProfileRow& b) -> bool {
+			return a.timings->GetTotalTicks() > b.timings->GetTotalTicks();
+		});
+		return rows;
+	}
+
+	void Draw(const std::map<std::string, Module*>& modules) {
+		if (!overlay)
+			return;
+
+		std::vector<ProfileRow> rows = GetRows(modules);
+		int count = min((int)rows.size(), PROFILE_OVERLAY_ROWS);
+		int width = 380, height = 28 + count * 14;
+		int x = Drawing::Hook::GetScreenWidth() - width - 10, y = 60;
+
+		Drawing::Boxhook::Draw(x, y, width, height, White, Drawing::BTBlack);
+		Drawing::TextBatch::Begin();
+		Drawing::Texthook::Draw(x + 5, y + 6, Drawing::None, 6, Gold, "Module");
+		Drawing::Texthook::Draw(x + 170, y + 6, Drawing::Right, 6, Gold, "Calls");
+		Drawing::Texthook::Draw(x + 240, y + 6, Drawing::Right, 6, Gold, "p50");
+		Drawing::Texthook::Draw(x + 305, y + 6, Drawing::Right, 6, Gold, "p95");
+		Drawing::Texthook::Draw(x + width - 5, y + 6, Drawing::Right, 6, Gold, "Max us");
+
+		for (int i = 0; i < count; i++) {
+			const EventTimings* timings = rows[i].timings;
+			int rowY = y + 22 + i * 14;
+			Drawing::Texthook::Draw(x + 5, rowY, Drawing::None, 6, White, "%s %s", rows[i].module.c_str(), GetEventName(rows[i].event));
+			Drawing::Texthook::Draw(x + 170, rowY, Drawing::Right, 6, White, "%u", timings->GetCount());
+			Drawing::Texthook::Draw(x + 240, rowY, Drawing::Right, 6, White, "%.0f", timings->GetPercentile(0.5));
+			Drawing::Texthook::Draw(x + 305, rowY, Drawing::Right, 6, White, "%.0f", timings->GetPercentile(0.95));
+			Drawing::Texthook::Draw(x + width - 5, rowY, Drawing::Right, 6, White, "%.0f", timings->GetMaxMicroseconds());
+		}
+		Drawing::TextBatch::End();
+	}
+
+	bool Dump(const std::map<std::string, Module*>& modules) {
+		std::ofstream file(BH::path + PROFILE_FILE, std::ofstream::trunc);
+		if (!file.is_open())
+			return false;
+
+		file << "module,event,calls,total_us,mean_us,p50_us,p95_us,max_us\n";
+		std::vector<ProfileRow> rows = GetRows(modules);
+		for (auto it = rows.begin(); it != rows.end(); it++) {
+			const EventTimings* timings = it->timings;
+			file << it->module << "," << GetEventName(it->event) << "," << timings->GetCount() << ","
+				<< timings->GetTotalMicroseconds() << "," << timings->GetTotalMicroseconds() / timings->GetCount() << ","
+				<< timings->GetPercentile(0.5) << "," << timings->GetPercentile(0.95) << ","
+				<< timings->GetMaxMicroseconds() << "\n";
+		}
+		return true;
+	}
+
+	void Reset(const std::map<std::string, Module*>& modules) {
+		for (auto it = modules.begin(); it != modules.end(); it++) {
+			for (int event = 0; event < EventCount; event++) {
+				it->second->GetTimings(event).Reset();
+			}
+		}
+	}
+
+	void Command(const std::map<std::string, Module*>& modules, const std::wstring& msg) {
+		if (msg.compare(L"dump") == 0) {
+			if (Dump(modules))
+				Print("c4BH:c0 Module timings written to %s", PROFILE_FILE);
+			else
+				Print("c4BH:c1 Failed to write %s", PROFILE_FILE);
+		}
+		else if (msg.compare(L"reset") == 0) {
+			Reset(modules);
+			Print("c4BH:c0 Module timings reset.");
+		}
+		else {
+			if (msg.compare(L"on") == 0)
+				enabled = true;
+			else if (msg.compare(L"off") == 0)
+				enabled = false;
+			else
+				enabled = !enabled;
+			overlay = enabled;
+			Print("c4BH:c0 Module profiling %s.", enabled ? "enabled" : "disabled");
+		}
+	}
+}
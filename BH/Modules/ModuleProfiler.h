@@ -0,0 +1,90 @@
+#pragma once
+#include <map>
+#include <string>
+#include <Windows.h>
+
+class Module;
+
+/*
+ * ModuleProfiler times every module event handler so slow frames can be
+ * traced back to the module causing them. Timings are only taken while
+ * profiling is enabled (.profile in chat), otherwise a handler costs a
+ * single branch.
+ */
+
+// 8 one microsecond buckets, then 4 buckets per power of two up to ~0.5s
+#define PROFILE_BUCKETS 72
+
+namespace ModuleProfiler {
+	enum ModuleEvent {
+		EventLoop,
+		EventDraw,
+		EventAutomapDraw,
+		EventOOGDraw,
+		EventGameJoin,
+		EventGameExit,
+		EventLeftClick,
+		EventRightClick,
+		EventKey,
+		EventChatPacket,
+		EventRealmPacket,
+		EventGamePacket,
+		EventChatMsg,
+		EventCount
+	};
+
+	class EventTimings {
+		private:
+			DWORD count;
+			ULONGLONG totalTicks;
+			ULONGLONG maxTicks;
+			DWORD buckets[PROFILE_BUCKETS];
+
+		public:
+			EventTimings() { Reset(); }
+
+			void Reset();
+			void Record(ULONGLONG ticks);
+
+			DWORD GetCount() const { return count; }
+			ULONGLONG GetTotalTicks() const { return totalTicks; }
+			double GetTotalMicroseconds() const;
+			double GetMaxMicroseconds() const;
+			// Upper bound of the bucket holding the given fraction of calls
+			double GetPercentile(double fraction) const;
+	};
+
+	extern bool enabled;
+	extern bool overlay;
+
+	// Times the enclosing block into the given event
+	class Scope {
+		private:
+			EventTimings& timings;
+			LARGE_INTEGER start;
+			bool active;
+
+		public:
+			Scope(EventTimings& timings) : timings(timings), active(enabled) {
+				if (active)
+					QueryPerformanceCounter(&start);
+			}
+
+			~Scope() {
+				if (active) {
+					LARGE_INTEGER end;
+					QueryPerformanceCounter(&end);
+					timings.Record(end.QuadPart - start.QuadPart);
+				}
+			}
+	};
+
+	const char* GetEventName(int event);
+
+	void Draw(const std::map<std::string, Module*>& modules);
+	bool Dump(const std::map<std::string, Module*>& modules);
+	void Reset(const std::map<std::string, Module*>& modules);
+
+	// .profile [on|off|dump|reset]
+	void Command(const std::map<std::string, Module*>& modules, const std::wstring& msg);
+}
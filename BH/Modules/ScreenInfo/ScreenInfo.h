@@ -55,6 +55,7 @@ class ScreenInfo : public Module {
 		void OnLoad();
 		void LoadConfig();
 		void MpqLoaded();
+		unsigned int MpqDependencies() { return MPQ_FILES; }
 		void OnKey(bool up, BYTE key, LPARAM lParam, bool* block);
 		void OnGameJoin();
 		void OnGameExit();
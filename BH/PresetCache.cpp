@@ -0,0 +1,242 @@
+#include "PresetCache.h"
+#include "BH.h"
+#include "D2Ptrs.h"
+#include <deque>
+#include <fstream>
+#include <map>
+
+// On-disk layout (little endian):
+//   header: DWORD magic, DWORD version, DWORD level count
+//   level:  DWORD seed, WORD level id, BYTE difficulty, WORD preset count
+//   preset: BYTE type, WORD txtFileNo, WORD targetLevel, WORD x, WORD y, WORD roomX, WORD roomY
+#define PRESET_CACHE_FILE		"presets.dat"
+#define PRESET_CACHE_MAGIC		0x43504842	// "BHPC"
+#define PRESET_CACHE_VERSION	1
+#define PRESET_CACHE_MAX_SEEDS	32
+
+class PresetLock {
+public:
+	CRITICAL_SECTION cSec;
+	PresetLock() { InitializeCriticalSection(&cSec); }
+	~PresetLock() { DeleteCriticalSection(&cSec); }
+};
+
+static PresetLock presetLock;
+static std::map<ULONGLONG, PresetListPtr> levelPresets;
+static std::deque<DWORD> seedOrder;	// Oldest seed first
+static bool loaded = false;
+static bool dirty = false;
+
+static ULONGLONG MakeKey(DWORD seed, BYTE difficulty, DWORD levelId) {
+	return ((ULONGLONG)seed << 32) | ((ULONGLONG)difficulty << 16) | (levelId & 0xFFFF);
+}
+
+template <typename T>
+static void Write(std::ofstream &file, T value) {
+	file.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+static bool Read(std::ifstream &file, T &value) {
+	file.read((char*)&value, sizeof(T));
+	return file.good();
+}
+
+// Marks the seed as the most recently used and drops the least recently
+// used seeds so the cache file can't grow without bounds. Must be called
+// with the lock held.
+static void TouchSeed(DWORD seed) {
+	for (auto it = seedOrder.begin(); it != seedOrder.end(); it++) {
+		if (*it == seed) {
+			seedOrder.erase(it);
+			break;
+		}
+	}
+	seedOrder.push_back(seed);
+
+	while (seedOrder.size() > PRESET_CACHE_MAX_SEEDS) {
+		DWORD oldest = seedOrder.front();
+		seedOrder.pop_front();
+		auto it = levelPresets.lower_bound(MakeKey(oldest, 0, 0));
+		while (it != levelPresets.end() && (DWORD)(it->first >> 32) == oldest)
+			it = levelPresets.erase(it);
+		dirty = true;
+	}
+}
+
+namespace PresetCache {
+	PresetListPtr Find(DWORD seed, BYTE difficulty, DWORD levelId) {
+		PresetListPtr presets;
+		EnterCriticalSection(&presetLock.cSec);
+		if (!loaded)
+			Load();
+		auto it = levelPresets.find(MakeKey(seed, difficulty, levelId));
+		if (it != levelPresets.end()) {
+			presets = it->second;
+			TouchSeed(seed);
+		}
+		LeaveCriticalSection(&presetLock.cSec);
+		return presets;
+	}
+
+	void ScanRoom(Room2* room, PresetList& presets) {
+		for (PresetUnit* preset = room->pPreset; preset; preset = preset->pPresetNext) {
+			if (preset->dwType != UNIT_MONSTER && preset->dwType != UNIT_OBJECT && preset->dwType != UNIT_TILE)
+				continue;
+
+			PresetPoint point;
+			point.type = (BYTE)preset->dwType;
+			point.txtFileNo = (WORD)preset->dwTxtFileNo;
+			point.targetLevel = 0;
+			point.x = (WORD)(preset->dwPosX + (room->dwPosX * 5));
+			point.y = (WORD)(preset->dwPosY + (room->dwPosY * 5));
+			point.roomX = (WORD)room->dwPosX;
+			point.roomY = (WORD)room->dwPosY;
+
+			if (preset->dwType == UNIT_TILE) {
+				for (RoomTile* tile = room->pRoomTiles; tile; tile = tile->pNext) {
+					if (*(tile->nNum) == preset->dwTxtFileNo) {
+						point.targetLevel = (WORD)tile->pRoom2->pLevel->dwLevelNo;
+						break;
+					}
+				}
+			}
+			presets.push_back(point);
+		}
+	}
+
+	PresetListPtr Store(DWORD seed, BYTE difficulty, DWORD levelId, const PresetList& presets) {
+		PresetListPtr stored = std::make_shared<PresetList>(presets);
+		EnterCriticalSection(&presetLock.cSec);
+		levelPresets[MakeKey(seed, difficulty, levelId)] = stored;
+		TouchSeed(seed);
+		dirty = true;
+		LeaveCriticalSection(&presetLock.cSec);
+		return stored;
+	}
+
+	PresetListPtr Get(Level* pLevel) {
+		UnitAny* player = D2CLIENT_GetPlayerUnit();
+		if (!pLevel || !player || !player->pAct)
+			return PresetListPtr();
+
+		DWORD seed = player->pAct->dwMapSeed;
+		BYTE difficulty = D2CLIENT_GetDifficulty();
+		PresetListPtr cached = Find(seed, difficulty, pLevel->dwLevelNo);
+		if (cached)
+			return cached;
+
+		if (!pLevel->pRoom2First)
+			D2COMMON_InitLevel(pLevel);
+
+		PresetList presets;
+		for (Room2* room = pLevel->pRoom2First; room; room = room->pRoom2Next) {
+			bool addedRoom = false;
+			if (!room->pRoom1) {
+				D2COMMON_AddRoomData(player->pAct, pLevel->dwLevelNo, room->dwPosX, room->dwPosY, player->pPath->pRoom1);
+				addedRoom = true;
+			}
+
+			ScanRoom(room, presets);
+
+			if (addedRoom)
+				D2COMMON_RemoveRoomData(player->pAct, pLevel->dwLevelNo, room->dwPosX, room->dwPosY, player->pPath->pRoom1);
+		}
+		return Store(seed, difficulty, pLevel->dwLevelNo, presets);
+	}
+
+	Room2* FindRoom(Level* pLevel, const PresetPoint& preset) {
+		if (!pLevel)
+			return NULL;
+		for (Room2* room = pLevel->pRoom2First; room; room = room->pRoom2Next) {
+			if (room->dwPosX == preset.roomX && room->dwPosY == preset.roomY)
+				return room;
+		}
+		return NULL;
+	}
+
+	bool Load() {
+		EnterCriticalSection(&presetLock.cSec);
+		loaded = true;
+		levelPresets.clear();
+		seedOrder.clear();
+
+		std::ifstream file(BH::path + PRESET_CACHE_FILE, std::ifstream::binary);
+		DWORD magic = 0, version = 0, count = 0;
+		bool ok = file.is_open() && Read(file, magic) && Read(file, version) && Read(file, count) &&
+			magic == PRESET_CACHE_MAGIC && version == PRESET_CACHE_VERSION;
+
+		for (DWORD i = 0; ok && i < count; i++) {
+			DWORD seed;
+			WORD levelId, presetCount;
+			BYTE difficulty;
+			if (!Read(file, seed) || !Read(file, levelId) || !Read(file, difficulty) || !Read(file, presetCount)) {
+				ok = false;
+				break;
+			}
+
+			PresetList presets(presetCount);
+			for (auto &point : presets) {
+				if (!Read(file, point.type) || !Read(file, point.txtFileNo) || !Read(file, point.targetLevel) ||
+						!Read(file, point.x) || !Read(file, point.y) || !Read(file, point.roomX) || !Read(file, point.roomY)) {
+					ok = false;
+					break;
+				}
+			}
+			if (!ok)
+				break;
+
+			levelPresets[MakeKey(seed, difficulty, levelId)] = std::make_shared<PresetList>(std::move(presets));
+			TouchSeed(seed);
+		}
+
+		// A truncated or outdated file is simply discarded
+		if (!ok) {
+			levelPresets.clear();
+			seedOrder.clear();
+		}
+		dirty = false;
+		LeaveCriticalSection(&presetLock.cSec);
+		return ok;
+	}
+
+	bool Save() {
+		EnterCriticalSection(&presetLock.cSec);
+		if (!dirty) {
+			LeaveCriticalSection(&presetLock.cSec);
+			return true;
+		}
+
+		std::ofstream file(BH::path + PRESET_CACHE_FILE, std::ofstream::binary | std::ofstream::trunc);
+		if (!file.is_open()) {
+			LeaveCriticalSection(&presetLock.cSec);
+			return false;
+		}
+
+		Write<DWORD>(file, PRESET_CACHE_MAGIC);
+		Write<DWORD>(file, PRESET_CACHE_VERSION);
+		Write<DWORD>(file, (DWORD)levelPresets.size());
+		// Written oldest seed first so Load restores the eviction order
+		for (auto seed = seedOrder.begin(); seed != seedOrder.end(); seed++) {
+			auto it = levelPresets.lower_bound(MakeKey(*seed, 0, 0));
+			for (; it != levelPresets.end() && (DWORD)(it->first >> 32) == *seed; it++) {
+				Write<DWORD>(file, *seed);
+				Write<WORD>(file, (WORD)(it->first & 0xFFFF));
+				Write<BYTE>(file, (BYTE)((it->first >> 16) & 0xFF));
+				Write<WORD>(file, (WORD)it->second->size());
+				for (auto &point : *it->second) {
+					Write(file, point.type);
+					Write(file, point.txtFileNo);
+					Write(file, point.targetLevel);
+					Write(file, point.x);
+					Write(file, point.y);
+					Write(file, point.roomX);
+					Write(file, point.roomY);
+				}
+			}
+		}
+		dirty = false;
+		LeaveCriticalSection(&presetLock.cSec);
+		return true;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Windows.h>
+#include <memory>
+#include <vector>
+#include "D2Structs.h"
+
+/*
+ * PresetCache remembers the preset units (special objects, monsters and
+ * level exit tiles) found in each level, keyed by map seed, difficulty and
+ * level id. Maps are generated from the seed so a rejoined game can skip
+ * walking the preset lists entirely. The cache is shared by Maphack and
+ * AutoTele and persisted to disk between sessions. Lists are handed out
+ * as shared pointers, so they stay valid when the cache drops them.
+ */
+
+struct PresetPoint {
+	BYTE type;				// UNIT_MONSTER, UNIT_OBJECT or UNIT_TILE
+	WORD txtFileNo;
+	WORD targetLevel;		// Destination level for exit tiles, 0 otherwise
+	WORD x, y;				// Absolute position
+	WORD roomX, roomY;		// Position of the owning Room2
+};
+
+typedef std::vector<PresetPoint> PresetList;
+typedef std::shared_ptr<const PresetList> PresetListPtr;
+
+namespace PresetCache {
+	// Returns the cached presets for the level, or NULL if it hasn't been scanned
+	PresetListPtr Find(DWORD seed, BYTE difficulty, DWORD levelId);
+
+	// Adds the presets of a room to the list. The room must have its room data loaded.
+	void ScanRoom(Room2* room, PresetList& presets);
+
+	// Stores a fully scanned level and returns the cached copy
+	PresetListPtr Store(DWORD seed, BYTE difficulty, DWORD levelId, const PresetList& presets);
+
+	// Returns the presets of a level in the current game, scanning it if needed
+	PresetListPtr Get(Level* pLevel);
+
+	// Finds the Room2 a cached preset belongs to
+	Room2* FindRoom(Level* pLevel, const PresetPoint& preset);
+
+	bool Load();
+	bool Save();
+}
@@ -184,15 +184,18 @@ int Table::size() {
 bool TableReader::loadMPQData(std::string archiveName, Table &table)
 {
 	std::transform(archiveName.begin(), archiveName.end(), archiveName.begin(), ::tolower);
-	MPQData* mpq = MpqDataMap[archiveName];
+	auto it = MpqDataMap.find(archiveName);
+	if (it == MpqDataMap.end()) return false;
+	MPQData* mpq = it->second;
 	if (!mpq || mpq->error) return false;
 	for (auto iter = mpq->data.begin(); iter != mpq->data.end(); iter++){
-		auto entry = *iter;
+		// The rows are shared with the MPQ data loaders, only read them
+		const std::map<std::string, std::string>& entry = *iter;
 		JSONObject *obj = new JSONObject();
 		for (auto header = mpq->fields.begin(); header != mpq->fields.end(); header++){
-			std::string h = *header;
-			if (entry[h].length() > 0){
-				obj->set(h, entry[h]);
+			auto field = entry.find(*header);
+			if (field != entry.end() && field->second.length() > 0){
+				obj->set(*header, field->second);
 			}
 		}
 		table.addEntry(obj);
@@ -287,42 +290,54 @@ Table Strings;
 Table Expansion;
 Table Patch;
 
-bool Tables::initTables(){
-	bool success = true;
-	if (!init){
-		init = true;
-		// Add tables here:
-		//success &= TableReader::readTable("data\\ItemStatCost.txt", ItemStatCost);		
-		//success &= TableReader::readTable("data\\ItemTypes.txt", ItemTypes);		
-		//success &= TableReader::readTable("data\\Properties.txt", Properties);		
-		//success &= TableReader::readTable("data\\runes.txt", Runewords);		
-		//success &= TableReader::readTable("data\\skills.txt", Skills);		
-		//success &= TableReader::readTable("data\\MagicPrefix.txt", MagicPrefix);		
-		//success &= TableReader::readTable("data\\MagicSuffix.txt", MagicSuffix);		
-		//success &= TableReader::readTable("data\\SetItems.txt", SetItems);
-		//success &= TableReader::readTable("data\\UniqueItems.txt", UniqueItems);
-
-		success &= TableReader::loadMPQData("itemstatcost", ItemStatCost);
-		success &= TableReader::loadMPQData("ItemTypes", ItemTypes);
-		success &= TableReader::loadMPQData("Properties", Properties);
-		success &= TableReader::loadMPQData("runes", Runewords);
-		success &= TableReader::loadMPQData("skills", Skills);
-		success &= TableReader::loadMPQData("MagicPrefix", MagicPrefix);
-		success &= TableReader::loadMPQData("MagicSuffix", MagicSuffix);
-		success &= TableReader::loadMPQData("UniqueItems", UniqueItems);
-		success &= TableReader::loadMPQData("SetItems", SetItems);
-		success &= TableReader::loadMPQData("RarePrefix", RarePrefix);
-		success &= TableReader::loadMPQData("RareSuffix", RareSuffix);
-		success &= TableReader::loadMPQData("CharStats", CharStats);
+struct MPQTable {
+	const char* archiveName;
+	Table* table;
+};
+
+// Add tables here:
+static const MPQTable mpqTables[] = {
+	{ "itemstatcost", &Tables::ItemStatCost },
+	{ "ItemTypes", &Tables::ItemTypes },
+	{ "Properties", &Tables::Properties },
+	{ "runes", &Tables::Runewords },
+	{ "skills", &Tables::Skills },
+	{ "MagicPrefix", &Tables::MagicPrefix },
+	{ "MagicSuffix", &Tables::MagicSuffix },
+	{ "UniqueItems", &Tables::UniqueItems },
+	{ "SetItems", &Tables::SetItems },
+	{ "RarePrefix", &Tables::RarePrefix },
+	{ "RareSuffix", &Tables::RareSuffix },
+	{ "CharStats", &Tables::CharStats },
+};
 
+bool Tables::beginInit(){
+	if (init){
+		return false;
+	}
+	init = true;
+	return true;
+}
+
+int Tables::tableCount(){
+	return sizeof(mpqTables) / sizeof(mpqTables[0]);
+}
+
+// Each table only touches its own data, so different tables can load concurrently
+bool Tables::loadTable(int index){
+	Table *table = mpqTables[index].table;
+	bool success = TableReader::loadMPQData(mpqTables[index].archiveName, *table);
+
+	if (table == &UniqueItems){
 		UniqueItems.removeWhere([](JSONElement* obj){
 			return ((JSONObject*)obj)->getString("index").compare("Expansion") == 0;
 		});
+	}
+	else if (table == &SetItems){
 		SetItems.removeWhere([](JSONElement* obj){
 			return ((JSONObject*)obj)->getString("item").length() == 0;
 		});
 	}
-
 	return success;
 }
 
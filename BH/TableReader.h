@@ -42,7 +42,12 @@ private:
 
 	Tables(){}
 public:
-	static bool initTables();
+	// Loading is split into steps so the tables can load in parallel:
+	// beginInit() returns false if someone already started loading them,
+	// otherwise each of the tableCount() tables is loaded with loadTable().
+	static bool beginInit();
+	static int tableCount();
+	static bool loadTable(int index);
 
 	static Table ItemStatCost;
 	static Table ItemTypes;
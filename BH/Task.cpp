@@ -1,79 +1,138 @@
 #include "Task.h"
-#include <Windows.h>
-#include <concurrent_queue.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <vector>
 
-class TaskHolder {
+// A pair of task lanes (one per priority) guarded by a single lock. Each
+// worker owns one and takes from the back, idle workers steal from the front.
+class WorkQueue {
+private:
+	std::mutex lock;
+	std::deque<std::function<void()>> lanes[Task::PriorityCount];
 public:
-	std::function<void()> task;
+	void push(std::function<void()> &&task, Task::Priority priority){
+		std::lock_guard<std::mutex> guard(lock);
+		lanes[priority].push_back(std::move(task));
+	}
+
+	bool popBack(int lane, std::function<void()> &task){
+		std::lock_guard<std::mutex> guard(lock);
+		if (lanes[lane].empty())
+			return false;
+		task = std::move(lanes[lane].back());
+		lanes[lane].pop_back();
+		return true;
+	}
 
-	TaskHolder(std::function<void()> _task){
-		task = _task;
+	bool popFront(int lane, std::function<void()> &task){
+		std::lock_guard<std::mutex> guard(lock);
+		if (lanes[lane].empty())
+			return false;
+		task = std::move(lanes[lane].front());
+		lanes[lane].pop_front();
+		return true;
 	}
 };
 
 class WorkerThread {
 public:
-	bool canceled;
-	HANDLE tHandle;
-
-	WorkerThread() :
-		canceled(false),
-		tHandle(NULL){
-	}
-
-	~WorkerThread(){
-		canceled = true;
-		CloseHandle(tHandle);
-	}
+	WorkQueue queue;
+	std::thread thread;
 };
 
-Concurrency::concurrent_queue<TaskHolder*> taskQueue;
+// Tasks enqueued from outside the pool (game thread, startup)
+WorkQueue injectQueue;
 std::vector<std::unique_ptr<WorkerThread>> threadPool;
-HANDLE waitHandle = NULL;
+std::mutex sleepLock;
+std::condition_variable wakeEvent;
+std::atomic<int> pendingTasks(0);
+std::atomic<bool> stopping(false);
+
+// Index of the worker running on this thread, -1 outside the pool. The
+// v120 toolset the DLL project uses predates thread_local.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+__declspec(thread) int workerIndex = -1;
+#else
+thread_local int workerIndex = -1;
+#endif
 
 namespace Task {
-	DWORD WINAPI QueueThread(void* arg){
-		WorkerThread *token = (WorkerThread*)arg;
-		
-		TaskHolder *t;
-		while (!token->canceled){
-			WaitForSingleObject(waitHandle, 2000);
-			if (token->canceled) break;
-
-			if (taskQueue.try_pop(t)){
-				if (!taskQueue.empty()) {
-					// Let the next task start while this one is processing
-					SetEvent(waitHandle);
+	static bool TryGetTask(int self, std::function<void()> &task){
+		int size = (int)threadPool.size();
+		for (int lane = 0; lane < PriorityCount; lane++){
+			if (threadPool[self]->queue.popBack(lane, task) || injectQueue.popFront(lane, task)){
+				return true;
+			}
+			for (int n = 1; n < size; n++){
+				if (threadPool[(self + n) % size]->queue.popFront(lane, task)){
+					return true;
 				}
+			}
+		}
+		return false;
+	}
+
+	static void QueueThread(int self){
+		workerIndex = self;
 
-				t->task();
-				delete t;
+		std::function<void()> task;
+		while (!stopping){
+			if (TryGetTask(self, task)){
+				pendingTasks--;
+				task();
+				task = nullptr;
+				continue;
 			}
+
+			std::unique_lock<std::mutex> guard(sleepLock);
+			wakeEvent.wait(guard, []() -> bool { return stopping || pendingTasks > 0; });
 		}
-		return 0;
 	}
 
 	void InitializeThreadPool(int size){
-		waitHandle = CreateEvent(NULL, false, false, NULL);
+		if (size <= 0){
+			// Leave a core for the game itself
+			size = std::max((int)std::thread::hardware_concurrency() - 1, 2);
+		}
 
+		// Create every queue before starting any thread so workers can steal safely
 		for (int i = 0; i < size; i++){
-			WorkerThread *t = new WorkerThread();
-
-			HANDLE tHandle = CreateThread(0, 0, QueueThread, (void*)t, 0, 0);
-			t->tHandle = tHandle;
-			threadPool.push_back(std::unique_ptr<WorkerThread>(t));
-
+			threadPool.push_back(std::unique_ptr<WorkerThread>(new WorkerThread()));
+		}
+		for (int i = 0; i < size; i++){
+			threadPool[i]->thread = std::thread(QueueThread, i);
 		}
 	}
 
 	void StopThreadPool(){
-		CloseHandle(waitHandle);
-		threadPool.clear();
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+			stopping = true;
+		}
+		wakeEvent.notify_all();
+
+		// Joining here could deadlock on the loader lock when called from DllMain
+		for (auto it = threadPool.begin(); it != threadPool.end(); it++){
+			(*it)->thread.detach();
+		}
 	}
 
-	void Enqueue(std::function<void()> task){
-		taskQueue.push(new TaskHolder(task));
-		SetEvent(waitHandle);
+	void Enqueue(std::function<void()> task, Priority priority){
+		// Work spawned by a worker stays local to it until someone steals it
+		if (workerIndex >= 0){
+			threadPool[workerIndex]->queue.push(std::move(task), priority);
+		}
+		else{
+			injectQueue.push(std::move(task), priority);
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+			pendingTasks++;
+		}
+		wakeEvent.notify_one();
 	}
-}
\ No newline at end of file
+}
@@ -1,9 +1,74 @@
 #pragma once
+#include <atomic>
+#include <exception>
 #include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
 
 namespace Task {
-	void InitializeThreadPool(int size);
+	// Frame critical work (draw builds) always runs before background work
+	// (MPQ loading, exports, anything touching the disk).
+	enum Priority {
+		FrameCritical = 0,
+		Background,
+		PriorityCount
+	};
+
+	// Cooperative cancellation. Canceled tasks that haven't started are
+	// skipped, running tasks can poll IsCanceled() to bail out early.
+	class CancellationToken {
+	private:
+		std::shared_ptr<std::atomic<bool>> canceled;
+	public:
+		CancellationToken() : canceled(std::make_shared<std::atomic<bool>>(false)) {}
+
+		void Cancel() const { *canceled = true; }
+		bool IsCanceled() const { return *canceled; }
+	};
+
+	// Set on the future of a task that was canceled before it ran
+	class TaskCanceled : public std::exception {
+	public:
+		const char* what() const throw() { return "Task canceled"; }
+	};
+
+	// A size of 0 sizes the pool from the hardware concurrency
+	void InitializeThreadPool(int size = 0);
 	void StopThreadPool();
 
-	void Enqueue(std::function<void()> task);
-}
\ No newline at end of file
+	void Enqueue(std::function<void()> task, Priority priority = Background);
+
+	template <typename T, typename F>
+	void Fulfill(std::promise<T> &promise, F &task) {
+		promise.set_value(task());
+	}
+
+	template <typename F>
+	void Fulfill(std::promise<void> &promise, F &task) {
+		task();
+		promise.set_value();
+	}
+
+	// Runs the task on the pool and returns a future for its result
+	template <typename F>
+	std::future<typename std::result_of<F()>::type> Run(F task, Priority priority = Background,
+			CancellationToken token = CancellationToken()) {
+		typedef typename std::result_of<F()>::type T;
+		auto promise = std::make_shared<std::promise<T>>();
+		std::future<T> result = promise->get_future();
+
+		Enqueue([=]() mutable -> void {
+			if (token.IsCanceled()) {
+				promise->set_exception(std::make_exception_ptr(TaskCanceled()));
+				return;
+			}
+			try {
+				Fulfill(*promise, task);
+			} catch (...) {
+				promise->set_exception(std::current_exception());
+			}
+		}, priority);
+		return result;
+	}
+}
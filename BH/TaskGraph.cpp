@@ -0,0 +1,69 @@
+#include "TaskGraph.h"
+
+namespace Task {
+	std::shared_ptr<Graph> Graph::Create(){
+		return std::shared_ptr<Graph>(new Graph());
+	}
+
+	Graph::Node Graph::Add(std::function<void()> task, const std::vector<Node> &dependencies, Priority priority){
+		if (started){
+			return -1;
+		}
+		Node node = (Node)nodes.size();
+
+		Entry *entry = new Entry();
+		entry->task = std::move(task);
+		entry->priority = priority;
+		entry->remaining = 0;
+		for (auto it = dependencies.begin(); it != dependencies.end(); it++){
+			if (*it >= 0 && *it < node){
+				nodes[*it]->dependents.push_back(node);
+				entry->remaining++;
+			}
+		}
+		nodes.push_back(std::unique_ptr<Entry>(entry));
+		return node;
+	}
+
+	void Graph::Start(){
+		if (started){
+			return;
+		}
+		started = true;
+
+		// Collect the roots first, a fast root could otherwise release a node
+		// we haven't looked at yet and it would be scheduled twice
+		std::vector<Node> roots;
+		for (Node node = 0; node < (Node)nodes.size(); node++){
+			if (nodes[node]->remaining == 0){
+				roots.push_back(node);
+			}
+		}
+		for (auto it = roots.begin(); it != roots.end(); it++){
+			Schedule(*it);
+		}
+	}
+
+	void Graph::Schedule(Node node){
+		std::shared_ptr<Graph> self = shared_from_this();
+		Enqueue([self, node]() -> void {
+			self->Complete(node);
+		}, nodes[node]->priority);
+	}
+
+	void Graph::Complete(Node node){
+		Entry *entry = nodes[node].get();
+		// A failing node still releases its dependents so one bad step
+		// can't stall the rest of the graph
+		try {
+			entry->task();
+		} catch (...) {}
+		entry->task = nullptr;
+
+		for (auto it = entry->dependents.begin(); it != entry->dependents.end(); it++){
+			if (--nodes[*it]->remaining == 0){
+				Schedule(*it);
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Task.h"
+#include <vector>
+
+namespace Task {
+	// A set of tasks with explicit dependencies. Every node is enqueued on the
+	// pool as soon as the last node it depends on finishes, so independent
+	// work runs in parallel. The graph keeps itself alive until it's done.
+	class Graph : public std::enable_shared_from_this<Graph> {
+	public:
+		typedef int Node;
+
+		static std::shared_ptr<Graph> Create();
+
+		// Dependencies must already be in the graph, which keeps it acyclic.
+		// Nodes can only be added before Start().
+		Node Add(std::function<void()> task, const std::vector<Node> &dependencies = std::vector<Node>(),
+			Priority priority = Background);
+
+		void Start();
+
+	private:
+		struct Entry {
+			std::function<void()> task;
+			Priority priority;
+			std::vector<Node> dependents;
+			std::atomic<int> remaining;
+		};
+
+		std::vector<std::unique_ptr<Entry>> nodes;
+		bool started;
+
+		Graph() : started(false) {}
+
+		void Schedule(Node node);
+		void Complete(Node node);
+	};
+}
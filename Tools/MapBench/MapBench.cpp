@@ -0,0 +1,590 @@
+//////////////////////////////////////////////////////////////////////
+// MapBench.cpp
+//
+// Path finding benchmark and regression check, built outside the game
+// from the AutoTele headers alone.
+//
+//   MapBench [--pairs n] [--seed n] map.bhm...
+//     Plans n seeded random start/end pairs on every map dump (see
+//     AutoTele::SaveMapDump) with CTeleportPath, CTeleportField and
+//     CWalkPath, and reports hops or waypoints, latency and failures.
+//
+//   MapBench --check [map.bhm...]
+//     Runs the same planners on a few small generated maps, and more
+//     thoroughly on any dumps given (see BH_MAPBENCH_CORPUS),
+//     and fails if a path is invalid or the planners disagree on
+//     whether the destination can be reached. Also checks the grid
+//     kernels against their plain per-cell versions.
+//
+//   MapBench --make map.bhm rooms-across rooms-down
+//     Writes a generated map, for benchmarking without game dumps.
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../BH/Modules/AutoTele/ATIncludes/MapDump.h"
+#include "../../BH/Modules/AutoTele/ATIncludes/TeleportPath.h"
+#include "../../BH/Modules/AutoTele/ATIncludes/WalkPath.h"
+
+#define BENCH_MAX_PATH		255		// Same buffer size AutoTele plans with
+#define BENCH_PAIRS			200
+#define BENCH_CHECK_PAIRS	100		// Per map dump given to --check
+#define BENCH_FIXTURE_MAPS	4		// Generated maps --check always runs on, kept small so ctest stays quick
+#define BENCH_FIXTURE_PAIRS	10
+
+typedef std::chrono::steady_clock Clock;
+
+static double GetMilliseconds(Clock::time_point tStart)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - tStart).count();
+}
+
+static int GetDistance2(POINT a, POINT b)
+{
+	return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Maps
+//////////////////////////////////////////////////////////////////////
+
+static void FillRect(CCollisionGrid& grid, int left, int top, int right, int bottom, uint16_t wValue)
+{
+	for (int y = max(top, 0); y < min(bottom, grid.GetCY()); y++)
+	{
+		for (int x = max(left, 0); x < min(right, grid.GetCX()); x++)
+			grid(x, y) = wValue;
+	}
+}
+
+// Rooms on a loose grid, most of them joined to their right and lower
+// neighbours by corridors, with a few blocked cells scattered over the
+// floor the way objects and props are in game
+static void MakeRooms(CMapDump& dump, std::mt19937& rng, int nRoomsX, int nRoomsY)
+{
+	const int CELL = 48;
+	dump.Clear();
+	dump.ptOrigin.x = 5000 + (int)(rng() % 1000);
+	dump.ptOrigin.y = 5000 + (int)(rng() % 1000);
+	dump.grid.Create(nRoomsX * CELL, nRoomsY * CELL, MAP_DUMP_BLOCKED);
+
+	std::vector<POINT> aCenters;
+	for (int ry = 0; ry < nRoomsY; ry++)
+	{
+		for (int rx = 0; rx < nRoomsX; rx++)
+		{
+			int cx = 12 + (int)(rng() % 30), cy = 12 + (int)(rng() % 30);
+			int left = rx * CELL + (int)(rng() % (CELL - cx)), top = ry * CELL + (int)(rng() % (CELL - cy));
+			FillRect(dump.grid, left, top, left + cx, top + cy, MAP_DUMP_OPEN);
+			POINT center = { left + cx / 2, top + cy / 2 };
+			aCenters.push_back(center);
+		}
+	}
+
+	for (int ry = 0; ry < nRoomsY; ry++)
+	{
+		for (int rx = 0; rx < nRoomsX; rx++)
+		{
+			const POINT& from = aCenters[ry * nRoomsX + rx];
+			for (int n = 0; n < 2; n++)
+			{
+				if ((n == 0 && rx + 1 == nRoomsX) || (n == 1 && ry + 1 == nRoomsY) || rng() % 5 == 0)
+					continue;
+
+				const POINT& to = aCenters[n == 0 ? ry * nRoomsX + rx + 1 : (ry + 1) * nRoomsX + rx];
+				int nWidth = 1 + (int)(rng() % 5);
+				FillRect(dump.grid, min(from.x, to.x), from.y, max(from.x, to.x) + nWidth, from.y + nWidth, MAP_DUMP_OPEN);
+				FillRect(dump.grid, to.x, min(from.y, to.y), to.x + nWidth, max(from.y, to.y) + nWidth, MAP_DUMP_OPEN);
+			}
+		}
+	}
+
+	for (int n = dump.grid.GetCX() * dump.grid.GetCY() / 100; n > 0; n--)
+		dump.grid((int)(rng() % dump.grid.GetCX()), (int)(rng() % dump.grid.GetCY())) = MAP_DUMP_BLOCKED;
+}
+
+static BOOL IsOpen(const CCollisionGrid& grid, POINT pt)
+{
+	return grid.IsValidIndex(pt.x, pt.y) && (grid(pt.x, pt.y) % 2) == 0;
+}
+
+// Random open cells, relative to the map
+static std::vector<POINT> GetOpenCells(const CCollisionGrid& grid, std::mt19937& rng, int nCount)
+{
+	std::vector<POINT> aCells;
+	for (int nTries = 0; (int)aCells.size() < nCount && nTries < nCount * 1000; nTries++)
+	{
+		POINT pt = { (int)(rng() % grid.GetCX()), (int)(rng() % grid.GetCY()) };
+		if (IsOpen(grid, pt))
+			aCells.push_back(pt);
+	}
+	return aCells;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Benchmark
+//////////////////////////////////////////////////////////////////////
+
+struct BenchResult
+{
+	const char* lpszName;
+	bool bPath;					// Makes paths, otherwise only the time counts
+	int nFound;
+	int nFailed;
+	double dLength;				// Points of all found paths
+	std::vector<double> aTimes;	// Milliseconds per plan
+
+	BenchResult(const char* lpszName, bool bPath) : lpszName(lpszName), bPath(bPath), nFound(0), nFailed(0), dLength(0) {}
+
+	void Add(DWORD dwCount, double dTime)
+	{
+		if (dwCount)
+		{
+			nFound++;
+			dLength += dwCount;
+		}
+		else
+			nFailed++;
+		aTimes.push_back(dTime);
+	}
+
+	void Print()
+	{
+		if (aTimes.empty())
+			return;
+
+		std::sort(aTimes.begin(), aTimes.end());
+		double dTotal = 0;
+		for (size_t i = 0; i < aTimes.size(); i++)
+			dTotal += aTimes[i];
+
+		if (bPath)
+			printf("  %-22s %6d %6d %9.1f", lpszName, nFound, nFailed, nFound ? dLength / nFound : 0.0);
+		else
+			printf("  %-22s %6s %6s %9s", lpszName, "", "", "");
+		printf(" %9.3f %9.3f %9.3f\n", dTotal / aTimes.size(), aTimes[aTimes.size() * 95 / 100], aTimes.back());
+	}
+};
+
+static void Bench(const char* lpszName, const CMapDump& dump, int nPairs, unsigned int nSeed)
+{
+	std::mt19937 rng(nSeed);
+	std::vector<POINT> aCells = GetOpenCells(dump.grid, rng, nPairs * 2);
+	nPairs = (int)aCells.size() / 2;
+
+	Clock::time_point tStart = Clock::now();
+	PathGridPtr pGrid = std::make_shared<CPathGrid>(dump.grid);
+	double dGrid = GetMilliseconds(tStart);
+
+	printf("%s: %dx%d, %d areas, %d pairs, path grid %.3f ms\n", lpszName, dump.grid.GetCX(), dump.grid.GetCY(),
+		(int)dump.aLevels.size(), nPairs, dGrid);
+	printf("  %-22s %6s %6s %9s %9s %9s %9s\n", "", "found", "failed", "points", "avg ms", "p95 ms", "max ms");
+
+	BenchResult teleport("CTeleportPath", true), build("CTeleportField build", false), query("CTeleportField query", true), walk("CWalkPath", true);
+	CWalkPath walker(*pGrid); // Kept like CWalkRoute keeps it, so its buffers are reused
+	POINT aPath[BENCH_MAX_PATH];
+	for (int i = 0; i < nPairs; i++)
+	{
+		POINT ptStart = aCells[2 * i], ptEnd = aCells[2 * i + 1];
+
+		tStart = Clock::now();
+		CTeleportPath path(*pGrid);
+		DWORD dwCount = path.FindTeleportPath(ptStart, ptEnd, aPath, BENCH_MAX_PATH);
+		teleport.Add(dwCount, GetMilliseconds(tStart));
+
+		POINT ptAbsStart = { ptStart.x + dump.ptOrigin.x, ptStart.y + dump.ptOrigin.y };
+		POINT ptAbsEnd = { ptEnd.x + dump.ptOrigin.x, ptEnd.y + dump.ptOrigin.y };
+		tStart = Clock::now();
+		CTeleportField field(pGrid, dump.ptOrigin, ptAbsEnd);
+		build.Add(1, GetMilliseconds(tStart));
+		tStart = Clock::now();
+		dwCount = field.FindPath(ptAbsStart, aPath, BENCH_MAX_PATH);
+		query.Add(dwCount, GetMilliseconds(tStart));
+
+		tStart = Clock::now();
+		dwCount = walker.FindWalkPath(ptStart, ptEnd, aPath, BENCH_MAX_PATH);
+		walk.Add(dwCount, GetMilliseconds(tStart));
+	}
+
+	teleport.Print();
+	build.Print();
+	query.Print();
+	walk.Print();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Checks
+//////////////////////////////////////////////////////////////////////
+
+static int s_nFailures = 0;
+
+static void Fail(const char* lpszMap, const char* lpszWhat, POINT ptStart, POINT ptEnd)
+{
+	printf("FAIL %s: %s, (%d, %d) to (%d, %d)\n", lpszMap, lpszWhat, (int)ptStart.x, (int)ptStart.y, (int)ptEnd.x, (int)ptEnd.y);
+	s_nFailures++;
+}
+
+// Starts and ends where asked, and every landing cell in between is open and one teleport from the last
+static BOOL IsTeleportPath(const CCollisionGrid& grid, const POINT* lpPath, DWORD dwCount, POINT ptStart, POINT ptEnd)
+{
+	if (dwCount < 2 || lpPath[0].x != ptStart.x || lpPath[0].y != ptStart.y || lpPath[dwCount - 1].x != ptEnd.x || lpPath[dwCount - 1].y != ptEnd.y)
+		return FALSE;
+
+	for (DWORD i = 1; i < dwCount; i++)
+	{
+		if (GetDistance2(lpPath[i - 1], lpPath[i]) >= 36 * 36 || (i + 1 < dwCount && !IsOpen(grid, lpPath[i])))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+// Same as above, with waypoints on open cells at most WALK_STEP apart
+static BOOL IsWalkPath(const CCollisionGrid& grid, const POINT* lpPath, DWORD dwCount, POINT ptStart, POINT ptEnd)
+{
+	if (dwCount < 2 || lpPath[0].x != ptStart.x || lpPath[0].y != ptStart.y || lpPath[dwCount - 1].x != ptEnd.x || lpPath[dwCount - 1].y != ptEnd.y)
+		return FALSE;
+
+	for (DWORD i = 1; i < dwCount; i++)
+	{
+		if (GetDistance2(lpPath[i - 1], lpPath[i]) > WALK_STEP * WALK_STEP || !IsOpen(grid, lpPath[i]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+// Cells reachable on foot from ptStart, by the rules CWalkPath::CanStep follows
+static std::vector<bool> GetWalkable(const CCollisionGrid& grid, POINT ptStart)
+{
+	const int CX = grid.GetCX();
+	std::vector<bool> aReached(CX * grid.GetCY(), false);
+	std::vector<POINT> aQueue(1, ptStart);
+	aReached[ptStart.y * CX + ptStart.x] = true;
+	for (size_t nHead = 0; nHead < aQueue.size(); nHead++)
+	{
+		POINT pt = aQueue[nHead];
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				POINT next = { pt.x + dx, pt.y + dy }, across = { pt.x + dx, pt.y }, down = { pt.x, pt.y + dy };
+				if (!IsOpen(grid, next) || aReached[next.y * CX + next.x])
+					continue;
+				if (dx != 0 && dy != 0 && (!IsOpen(grid, across) || !IsOpen(grid, down)))
+					continue;
+
+				aReached[next.y * CX + next.x] = true;
+				aQueue.push_back(next);
+			}
+		}
+	}
+	return aReached;
+}
+
+static void Check(const char* lpszName, const CMapDump& dump, unsigned int nSeed, int nPairs)
+{
+	std::mt19937 rng(nSeed);
+	std::vector<POINT> aCells = GetOpenCells(dump.grid, rng, nPairs * 2);
+	PathGridPtr pGrid = std::make_shared<CPathGrid>(dump.grid);
+
+	for (int y = 0; y < dump.grid.GetCY(); y++)
+	{
+		for (int x = 0; x < dump.grid.GetCX(); x++)
+		{
+			POINT pt = { x, y };
+			if (IsOpen(dump.grid, pt) != pGrid->IsOpen(x, y))
+			{
+				Fail(lpszName, "CPathGrid differs from the map", pt, pt);
+				return;
+			}
+		}
+	}
+
+	// Too large a map and the walking search may run out of budget on a path that exists
+	const bool bWalkComplete = dump.grid.GetCX() * dump.grid.GetCY() <= WALK_MAX_NODES;
+	CWalkPath walker(*pGrid); // One for all pairs, so later searches run on buffers earlier ones left behind
+	POINT aPath[BENCH_MAX_PATH];
+	for (size_t i = 0; i + 1 < aCells.size(); i += 2)
+	{
+		POINT ptStart = aCells[i], ptEnd = aCells[i + 1];
+		POINT ptAbsStart = { ptStart.x + dump.ptOrigin.x, ptStart.y + dump.ptOrigin.y };
+		POINT ptAbsEnd = { ptEnd.x + dump.ptOrigin.x, ptEnd.y + dump.ptOrigin.y };
+
+		CTeleportPath path(*pGrid);
+		DWORD dwTeleport = path.FindTeleportPath(ptStart, ptEnd, aPath, BENCH_MAX_PATH);
+		if (dwTeleport && !IsTeleportPath(dump.grid, aPath, dwTeleport, ptStart, ptEnd))
+			Fail(lpszName, "invalid CTeleportPath path", ptStart, ptEnd);
+
+		CTeleportField field(pGrid, dump.ptOrigin, ptAbsEnd);
+		DWORD dwField = field.FindPath(ptAbsStart, aPath, BENCH_MAX_PATH);
+		for (DWORD j = 0; j < dwField; j++)
+		{
+			aPath[j].x -= dump.ptOrigin.x;
+			aPath[j].y -= dump.ptOrigin.y;
+		}
+		if (dwField && !IsTeleportPath(dump.grid, aPath, dwField, ptStart, ptEnd))
+			Fail(lpszName, "invalid CTeleportField path", ptStart, ptEnd);
+
+		if ((dwTeleport != 0) != (dwField != 0))
+			Fail(lpszName, "CTeleportPath and CTeleportField disagree", ptStart, ptEnd);
+		else if (dwField > dwTeleport)
+			Fail(lpszName, "CTeleportField needs more hops than CTeleportPath", ptStart, ptEnd);
+
+		DWORD dwWalk = walker.FindWalkPath(ptStart, ptEnd, aPath, BENCH_MAX_PATH);
+		if (dwWalk && !IsWalkPath(dump.grid, aPath, dwWalk, ptStart, ptEnd))
+			Fail(lpszName, "invalid CWalkPath path", ptStart, ptEnd);
+
+		if (bWalkComplete && (dwWalk != 0) != GetWalkable(dump.grid, ptStart)[ptEnd.y * dump.grid.GetCX() + ptEnd.x])
+			Fail(lpszName, dwWalk ? "CWalkPath walked to an unreachable cell" : "CWalkPath missed a path", ptStart, ptEnd);
+
+		// A route through the box around both ends, which falls back to the whole map
+		RECT rcBox = { min(ptStart.x, ptEnd.x) - 8, min(ptStart.y, ptEnd.y) - 8, max(ptStart.x, ptEnd.x) + 8, max(ptStart.y, ptEnd.y) + 8 };
+		CWalkRoute route(pGrid, dump.ptOrigin, ptAbsEnd, std::vector<RECT>(1, rcBox));
+		for (int n = 0; n < 2; n++)
+		{
+			DWORD dwRoute = route.FindPath(ptAbsStart, aPath, BENCH_MAX_PATH);
+			for (DWORD j = 0; j < dwRoute; j++)
+			{
+				aPath[j].x -= dump.ptOrigin.x;
+				aPath[j].y -= dump.ptOrigin.y;
+			}
+			if (dwRoute && !IsWalkPath(dump.grid, aPath, dwRoute, ptStart, ptEnd))
+				Fail(lpszName, "invalid CWalkRoute path", ptStart, ptEnd);
+			if (bWalkComplete && (dwRoute != 0) != (dwWalk != 0))
+				Fail(lpszName, "CWalkRoute and CWalkPath disagree", ptStart, ptEnd);
+		}
+	}
+}
+
+// A dump written and read back has the same blocked cells
+static void CheckRoundTrip(const char* lpszName, const CMapDump& dump)
+{
+	const char* lpszFile = "MapBench.tmp.bhm";
+	CMapDump copy;
+	POINT none = { 0, 0 };
+	if (!dump.Save(lpszFile) || !copy.Load(lpszFile))
+	{
+		Fail(lpszName, "dump could not be saved and loaded", none, none);
+		remove(lpszFile);
+		return;
+	}
+	remove(lpszFile);
+
+	if (copy.ptOrigin.x != dump.ptOrigin.x || copy.ptOrigin.y != dump.ptOrigin.y || copy.aLevels != dump.aLevels ||
+		copy.aExits.size() != dump.aExits.size() || copy.grid.GetCX() != dump.grid.GetCX() || copy.grid.GetCY() != dump.grid.GetCY())
+	{
+		Fail(lpszName, "dump header changed on the way through a file", none, none);
+		return;
+	}
+
+	for (int y = 0; y < dump.grid.GetCY(); y++)
+	{
+		for (int x = 0; x < dump.grid.GetCX(); x++)
+		{
+			if ((copy.grid(x, y) % 2) != (dump.grid(x, y) % 2))
+			{
+				POINT pt = { x, y };
+				Fail(lpszName, "dump cells changed on the way through a file", pt, pt);
+				return;
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Kernel checks
+//////////////////////////////////////////////////////////////////////
+
+// The gap test FillGapCells replaced, one cell at a time
+static BOOL IsGapReference(const CCollisionGrid& grid, int x, int y)
+{
+	if (grid(x, y) % 2)
+		return FALSE;
+
+	int nSpaces = 0;
+	for (int i = x - 2; i <= x + 2 && nSpaces < 3; i++)
+		nSpaces = (i < 0 || i >= grid.GetCX() || (grid(i, y) % 2)) ? 0 : nSpaces + 1;
+	if (nSpaces < 3)
+		return TRUE;
+
+	nSpaces = 0;
+	for (int i = y - 2; i <= y + 2 && nSpaces < 3; i++)
+		nSpaces = (i < 0 || i >= grid.GetCY() || (grid(x, i) % 2)) ? 0 : nSpaces + 1;
+	return nSpaces < 3;
+}
+
+// CCollisionMap::FillGaps as it was before FillGapCells, column by column
+static void FillGapsReference(CCollisionGrid& grid, int left, int top, int right, int bottom, uint16_t wFill)
+{
+	for (int x = max(left, 0); x < min(right, grid.GetCX()); x++)
+	{
+		for (int y = max(top, 0); y < min(bottom, grid.GetCY()); y++)
+		{
+			if (IsGapReference(grid, x, y))
+				grid(x, y) = wFill;
+		}
+	}
+}
+
+// FillGapCells fills the same cells as the per-cell loop, over the whole map and parts of it
+static void CheckFillGaps(const char* lpszName, const CCollisionGrid& grid, std::mt19937& rng)
+{
+	const uint16_t FILL = 11111;
+	for (int n = 0; n < 8; n++)
+	{
+		int left = 0, top = 0, right = grid.GetCX(), bottom = grid.GetCY();
+		if (n > 0)
+		{
+			left = (int)(rng() % (grid.GetCX() + 8)) - 4;
+			top = (int)(rng() % (grid.GetCY() + 8)) - 4;
+			right = left + (int)(rng() % (grid.GetCX() + 8));
+			bottom = top + (int)(rng() % (grid.GetCY() + 8));
+		}
+
+		CCollisionGrid expected = grid, actual = grid;
+		FillGapsReference(expected, left, top, right, bottom, FILL);
+		FillGapCells(actual, left, top, right, bottom, FILL);
+		for (int y = 0; y < grid.GetCY(); y++)
+		{
+			if (!std::equal(expected.GetRow(y), expected.GetRow(y) + grid.GetCX(), actual.GetRow(y)))
+			{
+				POINT from = { left, top }, to = { right, bottom };
+				Fail(lpszName, "FillGapCells differs from the per-cell loop", from, to);
+				return;
+			}
+		}
+	}
+}
+
+// The SSE2 packers, when built, set the same bits as the plain C ones
+static void CheckPacking(std::mt19937& rng)
+{
+	const uint16_t aValues[] = { 0, 1, 2, 3, 11111, 11113, 0x7FFF, 0x8000, 0xFFFF };
+	std::vector<uint16_t> aRow;
+	std::vector<uint32_t> aExpected, aActual;
+	for (int cx = 1; cx <= 300; cx++)
+	{
+		aRow.resize(cx);
+		for (int x = 0; x < cx; x++)
+			aRow[x] = aValues[rng() % (sizeof(aValues) / sizeof(aValues[0]))];
+		aExpected.assign(GetRowWords(cx), 0x12345678);
+		aActual.assign(GetRowWords(cx), 0x87654321);
+
+		POINT size = { cx, 1 };
+		PackBlockedCellsScalar(&aRow[0], cx, &aExpected[0]);
+		PackBlockedCells(&aRow[0], cx, &aActual[0]);
+		if (aExpected != aActual)
+			Fail("packing", "PackBlockedCells differs from PackBlockedCellsScalar", size, size);
+
+		PackEqualCellsScalar(&aRow[0], cx, 11113, &aExpected[0]);
+		PackEqualCells(&aRow[0], cx, 11113, &aActual[0]);
+		if (aExpected != aActual)
+			Fail("packing", "PackEqualCells differs from PackEqualCellsScalar", size, size);
+	}
+}
+
+// Random cells, dense enough to leave plenty of gaps
+static void MakeNoise(CCollisionGrid& grid, std::mt19937& rng, int cx, int cy, int nBlockedPercent)
+{
+	grid.Create(cx, cy, 0);
+	for (int y = 0; y < cy; y++)
+	{
+		for (int x = 0; x < cx; x++)
+			grid(x, y) = (int)(rng() % 100) < nBlockedPercent ? (uint16_t)(1 + 2 * (rng() % 3)) : (uint16_t)(2 * (rng() % 2));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+	bool bCheck = false;
+	int nPairs = BENCH_PAIRS;
+	unsigned int nSeed = 1;
+	std::vector<std::string> aFiles;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--make" && i + 3 < argc)
+		{
+			CMapDump dump;
+			std::mt19937 rng(nSeed);
+			MakeRooms(dump, rng, max(1, atoi(argv[i + 2])), max(1, atoi(argv[i + 3])));
+			dump.aLevels.push_back(1);
+			return dump.Save(argv[i + 1]) ? 0 : 1;
+		}
+		else if (arg == "--check")
+			bCheck = true;
+		else if (arg == "--pairs" && i + 1 < argc)
+			nPairs = max(1, atoi(argv[++i]));
+		else if (arg == "--seed" && i + 1 < argc)
+			nSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if (arg.compare(0, 2, "--") == 0)
+		{
+			printf("usage: MapBench [--check] [--pairs n] [--seed n] [map.bhm...]\n       MapBench [--seed n] --make map.bhm rooms-across rooms-down\n");
+			return 2;
+		}
+		else
+			aFiles.push_back(arg);
+	}
+
+	if (!bCheck && aFiles.empty())
+	{
+		printf("usage: MapBench [--check] [--pairs n] [--seed n] [map.bhm...]\n       MapBench [--seed n] --make map.bhm rooms-across rooms-down\n");
+		return 2;
+	}
+
+	int nLoaded = 0;
+	for (size_t i = 0; i < aFiles.size(); i++)
+	{
+		CMapDump dump;
+		if (!dump.Load(aFiles[i].c_str()))
+		{
+			printf("%s: not a map dump\n", aFiles[i].c_str());
+			continue;
+		}
+
+		nLoaded++;
+		if (bCheck)
+		{
+			std::mt19937 rng(nSeed);
+			CheckRoundTrip(aFiles[i].c_str(), dump);
+			CheckFillGaps(aFiles[i].c_str(), dump.grid, rng);
+			Check(aFiles[i].c_str(), dump, nSeed, BENCH_CHECK_PAIRS);
+		}
+		else
+			Bench(aFiles[i].c_str(), dump, nPairs, nSeed);
+	}
+
+	if (!bCheck)
+		return nLoaded == (int)aFiles.size() ? 0 : 1;
+
+	std::mt19937 rng(nSeed);
+	CheckPacking(rng);
+	for (int n = 0; n < 8; n++)
+	{
+		char szName[32];
+		sprintf(szName, "noise %d", n);
+		CCollisionGrid grid;
+		MakeNoise(grid, rng, 1 + (int)(rng() % 200), 1 + (int)(rng() % 200), 5 + 10 * n);
+		CheckFillGaps(szName, grid, rng);
+	}
+
+	for (int n = 0; n < BENCH_FIXTURE_MAPS; n++)
+	{
+		CMapDump dump;
+		MakeRooms(dump, rng, 4 + n, 3 + n / 2);
+		dump.aLevels.push_back(n + 1);
+		char szName[32];
+		sprintf(szName, "rooms %d", n);
+		CheckRoundTrip(szName, dump);
+		CheckFillGaps(szName, dump.grid, rng);
+		Check(szName, dump, nSeed + n, BENCH_FIXTURE_PAIRS);
+	}
+
+	printf("%d map dumps, %d failures\n", nLoaded, s_nFailures);
+	return s_nFailures == 0 && nLoaded == (int)aFiles.size() ? 0 : 1;
+}
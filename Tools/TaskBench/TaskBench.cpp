@@ -0,0 +1,421 @@
+//////////////////////////////////////////////////////////////////////
+// TaskBench.cpp
+//
+// Stress benchmark and regression check for the task pool (Task.cpp)
+// and task graphs (TaskGraph.cpp), built outside the game.
+//
+//   TaskBench [--threads n] [--tasks n]
+//     Pushes n tasks through the pool in several patterns and reports
+//     throughput and latency.
+//
+//   TaskBench --check [--threads n]
+//     Checks work stealing, the two priority lanes, cancellation,
+//     future results and graph ordering, then runs a short stress.
+//////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../BH/Task.h"
+#include "../../BH/TaskGraph.h"
+
+#define BENCH_THREADS	4
+#define BENCH_TASKS		200000
+#define CHECK_TASKS		20000
+
+typedef std::chrono::steady_clock Clock;
+
+static double GetMilliseconds(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static int failures = 0;
+
+static void Fail(const char *what) {
+	printf("FAIL %s\n", what);
+	failures++;
+}
+
+// Waits for a future without hanging the run if the pool loses a task
+template <typename T>
+static bool Ready(std::future<T> &result, const char *what) {
+	if (result.wait_for(std::chrono::seconds(10)) == std::future_status::ready)
+		return true;
+	Fail(what);
+	return false;
+}
+
+// Holds every worker until Open(), so tasks queued meanwhile are all
+// waiting when the workers start picking
+class Gate {
+private:
+	std::mutex lock;
+	std::condition_variable changed;
+	int held;
+	bool open;
+public:
+	Gate() : held(0), open(false) {}
+
+	bool Close(int threads) {
+		for (int i = 0; i < threads; i++) {
+			Task::Enqueue([this]() -> void {
+				std::unique_lock<std::mutex> guard(lock);
+				held++;
+				changed.notify_all();
+				changed.wait(guard, [this]() -> bool { return open; });
+				held--;
+				changed.notify_all();
+			}, Task::FrameCritical);
+		}
+		std::unique_lock<std::mutex> guard(lock);
+		return changed.wait_for(guard, std::chrono::seconds(10), [&]() -> bool { return held == threads; });
+	}
+
+	// Returns once every worker has let go of the gate, so it can be destroyed
+	void Open() {
+		std::unique_lock<std::mutex> guard(lock);
+		open = true;
+		changed.notify_all();
+		changed.wait(guard, [this]() -> bool { return held == 0; });
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// Checks
+//////////////////////////////////////////////////////////////////////
+
+// Values, void and exceptions all come back through the future
+static void CheckResults() {
+	std::vector<std::future<int>> results;
+	for (int i = 0; i < 1000; i++)
+		results.push_back(Task::Run([i]() -> int { return i * i; }));
+	for (int i = 0; i < (int)results.size(); i++) {
+		if (!Ready(results[i], "result never arrived"))
+			return;
+		if (results[i].get() != i * i) {
+			Fail("wrong result");
+			return;
+		}
+	}
+
+	std::atomic<int> ran(0);
+	std::future<void> done = Task::Run([&ran]() -> void { ran++; });
+	if (Ready(done, "void task never finished")) {
+		done.get();
+		if (ran != 1)
+			Fail("void task didn't run");
+	}
+
+	std::future<int> thrown = Task::Run([]() -> int { throw std::runtime_error("expected"); });
+	if (Ready(thrown, "throwing task never finished")) {
+		try {
+			thrown.get();
+			Fail("exception was lost");
+		} catch (const std::runtime_error&) {
+		} catch (...) {
+			Fail("exception changed type");
+		}
+	}
+}
+
+// A task canceled before it starts never runs and resolves to
+// TaskCanceled, a running task sees the cancellation
+static void CheckCancellation(int threads) {
+	Gate gate;
+	if (!gate.Close(threads)) {
+		Fail("workers never blocked");
+		gate.Open();
+		return;
+	}
+
+	Task::CancellationToken token;
+	std::atomic<int> ran(0);
+	std::vector<std::future<void>> canceled;
+	for (int i = 0; i < 100; i++)
+		canceled.push_back(Task::Run([&ran]() -> void { ran++; }, Task::Background, token));
+	std::future<int> kept = Task::Run([]() -> int { return 7; }, Task::Background, Task::CancellationToken());
+	token.Cancel();
+	gate.Open();
+
+	for (size_t i = 0; i < canceled.size(); i++) {
+		if (!Ready(canceled[i], "canceled task never resolved"))
+			return;
+		try {
+			canceled[i].get();
+			Fail("canceled task resolved normally");
+		} catch (const Task::TaskCanceled&) {
+		} catch (...) {
+			Fail("canceled task resolved to another exception");
+		}
+	}
+	if (ran != 0)
+		Fail("canceled task ran");
+	if (Ready(kept, "uncanceled task never finished") && kept.get() != 7)
+		Fail("uncanceled task lost its result");
+
+	Task::CancellationToken running;
+	std::atomic<bool> started(false);
+	std::future<bool> polled = Task::Run([&]() -> bool {
+		started = true;
+		Clock::time_point start = Clock::now();
+		while (!running.IsCanceled() && GetMilliseconds(start) < 10000)
+			std::this_thread::yield();
+		return running.IsCanceled();
+	}, Task::Background, running);
+	while (!started)
+		std::this_thread::yield();
+	running.Cancel();
+	if (Ready(polled, "running task never saw the cancellation") && !polled.get())
+		Fail("running task never saw the cancellation");
+}
+
+// With every worker busy, frame critical work queued after background
+// work still starts before any of it
+static void CheckPriorities(int threads) {
+	Gate gate;
+	if (!gate.Close(threads)) {
+		Fail("workers never blocked");
+		gate.Open();
+		return;
+	}
+
+	std::mutex lock;
+	std::vector<Task::Priority> order;
+	std::vector<std::future<void>> results;
+	for (int i = 0; i < 200; i++) {
+		Task::Priority priority = i < 100 ? Task::Background : Task::FrameCritical;
+		results.push_back(Task::Run([&lock, &order, priority]() -> void {
+			std::lock_guard<std::mutex> guard(lock);
+			order.push_back(priority);
+		}, priority));
+	}
+	gate.Open();
+
+	for (size_t i = 0; i < results.size(); i++) {
+		if (!Ready(results[i], "prioritized task never finished"))
+			return;
+	}
+
+	// Workers may finish out of order, but none picks background work
+	// while frame critical work is queued. Starts and finishes are at
+	// most a thread count apart.
+	size_t lastCritical = 0;
+	for (size_t i = 0; i < order.size(); i++) {
+		if (order[i] == Task::FrameCritical)
+			lastCritical = i;
+	}
+	if (lastCritical >= 100 + (size_t)threads)
+		Fail("background work ran ahead of frame critical work");
+}
+
+// Tasks spawned by a worker go to its own queue. With that worker
+// waiting on them, they only finish if other workers steal them.
+static void CheckStealing(int threads) {
+	if (threads < 2)
+		return;
+
+	std::future<std::set<std::thread::id>> result = Task::Run([]() -> std::set<std::thread::id> {
+		std::mutex lock;
+		std::set<std::thread::id> ids;
+		std::vector<std::future<void>> children;
+		for (int i = 0; i < 64; i++) {
+			children.push_back(Task::Run([&]() -> void {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				std::lock_guard<std::mutex> guard(lock);
+				ids.insert(std::this_thread::get_id());
+			}));
+		}
+		for (size_t i = 0; i < children.size(); i++)
+			children[i].wait();
+		if (ids.count(std::this_thread::get_id()))
+			throw std::logic_error("spawning worker ran its own task while waiting");
+		return ids;
+	});
+
+	if (!Ready(result, "spawned tasks were never stolen"))
+		return;
+	try {
+		if (result.get().size() < 2 && threads > 2)
+			Fail("only one worker stole");
+	} catch (...) {
+		Fail("spawning worker ran its own task while waiting");
+	}
+}
+
+// Every node runs after the nodes it depends on
+static void CheckGraph() {
+	const int count = 200;
+	std::shared_ptr<Task::Graph> graph = Task::Graph::Create();
+	std::vector<std::atomic<int>> finished(count);
+	std::atomic<int> counter(0), wrong(0);
+	std::promise<void> done;
+	std::vector<Task::Graph::Node> nodes;
+	for (int i = 0; i < count; i++) {
+		std::vector<Task::Graph::Node> dependencies;
+		if (i > 0)
+			dependencies.push_back(nodes[i / 2]);
+		if (i > 1)
+			dependencies.push_back(nodes[i - 1]);
+		nodes.push_back(graph->Add([&, i, dependencies]() -> void {
+			for (size_t n = 0; n < dependencies.size(); n++) {
+				if (finished[dependencies[n]] == 0)
+					wrong++;
+			}
+			int order = ++counter;
+			finished[i] = order;
+			if (order == count)
+				done.set_value();
+		}, dependencies, i % 2 ? Task::Background : Task::FrameCritical));
+	}
+	graph->Start();
+
+	std::future<void> result = done.get_future();
+	if (Ready(result, "graph never finished") && wrong != 0)
+		Fail("graph node ran before its dependencies");
+}
+
+//////////////////////////////////////////////////////////////////////
+// Stress
+//////////////////////////////////////////////////////////////////////
+
+// Many small tasks from outside the pool, each returning through a future
+static void StressInject(int tasks) {
+	Clock::time_point start = Clock::now();
+	std::vector<std::future<int>> results;
+	results.reserve(tasks);
+	for (int i = 0; i < tasks; i++)
+		results.push_back(Task::Run([i]() -> int { return i; }, i % 4 ? Task::Background : Task::FrameCritical));
+
+	long long sum = 0;
+	for (int i = 0; i < tasks; i++) {
+		if (!Ready(results[i], "stress task never finished"))
+			return;
+		sum += results[i].get();
+	}
+	double elapsed = GetMilliseconds(start);
+	if (sum != (long long)tasks * (tasks - 1) / 2)
+		Fail("stress results don't add up");
+	printf("  %-24s %9d tasks %9.1f ms %9.0f tasks/s\n", "injected, with futures", tasks, elapsed, tasks / elapsed * 1000);
+}
+
+// A tree of tasks spawned from inside the pool, spread by stealing
+static void StressSpawn(int tasks) {
+	struct Spawn {
+		static void Run(std::atomic<int> *left, std::promise<void> *done, int count) {
+			// Split until small, so every worker has something to steal
+			while (count > 1) {
+				int half = count / 2;
+				Task::Enqueue([=]() -> void { Spawn::Run(left, done, half); });
+				count -= half;
+			}
+			if (--*left == 0)
+				done->set_value();
+		}
+	};
+
+	Clock::time_point start = Clock::now();
+	std::atomic<int> left(tasks);
+	std::promise<void> done;
+	std::future<void> result = done.get_future();
+	Task::Enqueue([&]() -> void { Spawn::Run(&left, &done, tasks); });
+	if (!Ready(result, "spawned tree never finished"))
+		return;
+	double elapsed = GetMilliseconds(start);
+	printf("  %-24s %9d tasks %9.1f ms %9.0f tasks/s\n", "spawned from workers", tasks, elapsed, tasks / elapsed * 1000);
+}
+
+// Time from Enqueue to start, for frame critical work behind a
+// constant stream of background work
+static void StressLatency(int tasks) {
+	std::atomic<bool> flooding(true);
+	std::atomic<int> background(0);
+	std::thread flood([&]() -> void {
+		while (flooding) {
+			if (background < 1000) {
+				background++;
+				Task::Enqueue([&background]() -> void {
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+					background--;
+				});
+			}
+			else
+				std::this_thread::yield();
+		}
+	});
+
+	int samples = std::max(tasks / 1000, 50);
+	std::vector<double> waits;
+	for (int i = 0; i < samples; i++) {
+		Clock::time_point queued = Clock::now();
+		std::future<double> result = Task::Run([queued]() -> double { return GetMilliseconds(queued); }, Task::FrameCritical);
+		if (!Ready(result, "frame critical task starved"))
+			break;
+		waits.push_back(result.get());
+	}
+	flooding = false;
+	flood.join();
+	while (background > 0)
+		std::this_thread::yield();
+
+	if (waits.empty())
+		return;
+	std::sort(waits.begin(), waits.end());
+	double total = 0;
+	for (size_t i = 0; i < waits.size(); i++)
+		total += waits[i];
+	printf("  %-24s %9d tasks  avg %.3f ms  p95 %.3f ms  max %.3f ms\n", "frame critical latency", (int)waits.size(),
+		total / waits.size(), waits[waits.size() * 95 / 100], waits.back());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[]) {
+	bool check = false;
+	int threads = BENCH_THREADS;
+	int tasks = BENCH_TASKS;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--check")
+			check = true;
+		else if (arg == "--threads" && i + 1 < argc)
+			threads = std::max(1, atoi(argv[++i]));
+		else if (arg == "--tasks" && i + 1 < argc)
+			tasks = std::max(1, atoi(argv[++i]));
+		else {
+			printf("usage: TaskBench [--check] [--threads n] [--tasks n]\n");
+			return 2;
+		}
+	}
+
+	Task::InitializeThreadPool(threads);
+	printf("%d workers\n", threads);
+	if (check) {
+		CheckResults();
+		CheckCancellation(threads);
+		CheckPriorities(threads);
+		CheckStealing(threads);
+		CheckGraph();
+		tasks = std::min(tasks, CHECK_TASKS);
+	}
+
+	StressInject(tasks);
+	StressSpawn(tasks);
+	StressLatency(tasks);
+
+	printf("%d failures\n", failures);
+	fflush(stdout);
+
+	// StopThreadPool detaches the workers, which would still be running
+	// while the pool's globals are destroyed, so skip the destructors
+	Task::StopThreadPool();
+	std::_Exit(failures == 0 ? 0 : 1);
+}